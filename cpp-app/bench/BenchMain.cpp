@@ -0,0 +1,779 @@
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QHash>
+#include <QSet>
+#include <QHeaderView>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QStandardItemModel>
+#include <QTableView>
+#include <QTemporaryDir>
+#include <QTemporaryFile>
+#include <QTimer>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+
+#include "ApiClient.h"
+#include "BenchSuite.h"
+#include "BulkImporter.h"
+#include "Compression.h"
+#include "DateUtils.h"
+#include "DueIndex.h"
+#include "JsonRowStream.h"
+#include "Legacy.h"
+#include "LocalBackend.h"
+#include "Perf.h"
+#include "PhoneIndex.h"
+#include "RecordColumns.h"
+#include "RecordExporter.h"
+#include "RecordSearch.h"
+#include "RecordTableModel.h"
+#include "Records.h"
+#include "SyntheticData.h"
+
+namespace {
+const int kChunkBytes = 16 * 1024;
+
+volatile qint64 sink = 0;
+
+void benchParse(BenchSuite &suite, int rows, const QByteArray &body) {
+    suite.run("parse.document", rows, [&]() {
+        ApiClient::Result result = ApiClient::parseJsonResult(body, true, QString());
+        QVector<QJsonObject> objects;
+        objects.reserve(result.rows.size());
+        for (const auto &value : result.rows) {
+            objects.append(value.toObject());
+        }
+        sink += objects.size();
+    });
+
+    if (!suite.enabled("parse.stream")) {
+        return;
+    }
+    QVector<double> totals;
+    QVector<double> firsts;
+    for (int i = 0; i < suite.options().iterations; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        JsonRowStream stream;
+        QJsonArray parsed;
+        double first = -1;
+        for (qsizetype offset = 0; offset < body.size(); offset += kChunkBytes) {
+            QJsonArray chunk;
+            stream.feed(body.mid(offset, kChunkBytes), &chunk);
+            if (first < 0 && !chunk.isEmpty()) {
+                first = timer.nsecsElapsed() / 1e6;
+            }
+            for (const auto &row : chunk) {
+                parsed.append(row);
+            }
+        }
+        QJsonObject envelope;
+        stream.finish(&envelope);
+        totals.append(timer.nsecsElapsed() / 1e6);
+        firsts.append(first);
+    }
+    suite.record("parse.stream", rows, totals);
+    suite.record("parse.stream.first_rows", rows, firsts);
+}
+
+void benchWire(BenchSuite &suite, int rows, const QByteArray &body, const QJsonArray &json) {
+    suite.recordBytes("wire.get.json", rows, body.size(), body.size());
+    suite.recordBytes("wire.get.gzip", rows, Compression::gzip(body).size(), body.size());
+
+    qint64 postIndented = 0;
+    qint64 postCompact = 0;
+    qint64 postGzip = 0;
+    QByteArray batch = "{\"type\":\"customer_service_batch\",\"timestamp\":0,\"records\":[";
+    for (const auto &row : json) {
+        QJsonObject payload;
+        payload.insert("type", "customer_service");
+        payload.insert("timestamp", 0);
+        payload.insert("data", row.toObject());
+        const QByteArray compact = QJsonDocument(payload).toJson(QJsonDocument::Compact);
+        const QByteArray gzipped = Compression::gzip(compact);
+        postIndented += QJsonDocument(payload).toJson(QJsonDocument::Indented).size();
+        postCompact += compact.size();
+        postGzip += gzipped.isEmpty() ? compact.size() : qMin(compact.size(), gzipped.size());
+        if (batch.endsWith('}')) {
+            batch += ',';
+        }
+        batch += QJsonDocument(row.toObject()).toJson(QJsonDocument::Compact);
+    }
+    batch += "]}";
+    suite.recordBytes("wire.post.indented", rows, postIndented, postIndented);
+    suite.recordBytes("wire.post.compact", rows, postCompact, postIndented);
+    suite.recordBytes("wire.post.gzip", rows, postGzip, postIndented);
+    suite.recordBytes("wire.batch.compact", rows, batch.size(), postIndented);
+    suite.recordBytes("wire.batch.gzip", rows, Compression::gzip(batch).size(), postIndented);
+
+    suite.check("compression.crc32", Compression::crc32("123456789") == 0xCBF43926u ? 0 : 1);
+    suite.run("compress.gzip", rows, [&]() {
+        sink += Compression::gzip(body).size();
+    });
+}
+
+void benchRows(BenchSuite &suite, int rows, const QJsonArray &json) {
+    QVector<Records::ServiceRecord> decoded = Records::decodeRows(json);
+    QVector<Records::ServiceRecord> working;
+
+    suite.run("rows.decode", rows, [&]() {
+        sink += Records::decodeRows(json).size();
+    });
+    suite.run("rows.sort", rows, [&]() {
+        Records::sortNewestFirst(working);
+        Records::assignWaterRanks(working);
+    }, [&]() {
+        working = decoded;
+    });
+
+    Records::sortNewestFirst(decoded);
+    Records::assignWaterRanks(decoded);
+    suite.run("rows.display", rows, [&]() {
+        for (const auto &record : decoded) {
+            sink += Records::displayRow(record, false).size();
+        }
+    });
+    suite.run("rows.pipeline.legacy", rows, [&]() {
+        sink += Legacy::displayRows(json, false).size();
+    });
+    suite.run("rows.pipeline.typed", rows, [&]() {
+        QVector<Records::ServiceRecord> records = Records::decodeRows(json);
+        Records::sortNewestFirst(records);
+        Records::assignWaterRanks(records);
+        for (const auto &record : records) {
+            sink += Records::displayRow(record, false).size();
+        }
+    });
+}
+
+// Longest gap between 1 ms timer ticks while the result pipeline runs, i.e. the worst frame the user would see.
+void benchStalls(BenchSuite &suite, int rows, const QJsonArray &json) {
+    const auto pipeline = [&json]() {
+        QVector<Records::ServiceRecord> records = Records::decodeRows(json);
+        Records::sortNewestFirst(records);
+        Records::assignWaterRanks(records);
+        return records.size();
+    };
+
+    if (suite.enabled("ui.stall.inline")) {
+        QVector<double> samples;
+        for (int i = 0; i < suite.options().iterations; ++i) {
+            QElapsedTimer timer;
+            timer.start();
+            sink += pipeline();
+            samples.append(timer.nsecsElapsed() / 1e6);
+        }
+        suite.record("ui.stall.inline", rows, samples);
+    }
+
+    if (suite.enabled("ui.stall.offloaded")) {
+        QVector<double> samples;
+        for (int i = 0; i < suite.options().iterations; ++i) {
+            QEventLoop loop;
+            QTimer ticker;
+            QElapsedTimer sinceTick;
+            double worstMs = 0;
+            ticker.setInterval(1);
+            QObject::connect(&ticker, &QTimer::timeout, [&]() {
+                worstMs = qMax(worstMs, sinceTick.nsecsElapsed() / 1e6);
+                sinceTick.restart();
+            });
+            sinceTick.start();
+            ticker.start();
+            QtConcurrent::run(pipeline).then(&loop, [&](qsizetype count) {
+                sink += count;
+                worstMs = qMax(worstMs, sinceTick.nsecsElapsed() / 1e6);
+                loop.quit();
+            });
+            loop.exec();
+            samples.append(worstMs);
+        }
+        suite.record("ui.stall.offloaded", rows, samples);
+    }
+}
+
+void benchTable(BenchSuite &suite, int rows, const QJsonArray &json) {
+    QVector<Records::ServiceRecord> records = Records::decodeRows(json);
+    Records::sortNewestFirst(records);
+    Records::assignWaterRanks(records);
+    const QList<QStringList> displayRows = Legacy::displayRows(json, false);
+
+    if (suite.enabled("table.standard_items")) {
+        QStandardItemModel model;
+        QTableView view;
+        view.resize(1200, 800);
+        view.setModel(&model);
+        view.horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+        suite.run("table.standard_items", rows, [&]() {
+            model.clear();
+            model.setColumnCount(Records::kColumnCount);
+            model.setHorizontalHeaderLabels(Records::displayHeaders());
+            for (const auto &row : displayRows) {
+                QList<QStandardItem *> items;
+                for (const auto &cell : row) {
+                    items.append(new QStandardItem(cell));
+                }
+                model.appendRow(items);
+            }
+            sink += view.grab().width();
+        });
+    }
+
+    if (suite.enabled("table.record_model")) {
+        RecordTableModel model;
+        QTableView view;
+        view.resize(1200, 800);
+        view.setModel(&model);
+        view.horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
+        view.horizontalHeader()->setStretchLastSection(true);
+        view.verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+        suite.run("table.record_model", rows, [&]() {
+            model.setRecords(std::make_shared<const QVector<Records::ServiceRecord>>(records), false);
+            sink += view.grab().width();
+        });
+    }
+}
+
+void benchDue(BenchSuite &suite, int rows, const QJsonArray &json) {
+    const QVector<Records::ServiceRecord> records = Records::decodeRows(json);
+    const QDate from(2020, 5, 15);
+    const QDate to = from.addDays(30);
+
+    DueIndex index;
+    suite.run("due.build", rows, [&]() {
+        for (const auto &record : records) {
+            index.addRecord(record);
+        }
+    }, [&]() {
+        index.clear();
+    });
+
+    int expected = 0;
+    QHash<QString, const Records::ServiceRecord *> latestWater;
+    for (const auto &record : records) {
+        const QDate warranty = DateUtils::rocToAdDate(record.warrantyEndRoc);
+        expected += warranty.isValid() && warranty >= from && warranty <= to;
+        if (record.itemMask & Records::WaterItem) {
+            const Records::ServiceRecord *&latest = latestWater[record.phone];
+            if (!latest || record.serviceDay > latest->serviceDay
+                || (record.serviceDay == latest->serviceDay && record.createdMs > latest->createdMs)) {
+                latest = &record;
+            }
+        }
+    }
+    for (const auto *record : std::as_const(latestWater)) {
+        const QDate due = DateUtils::rocToAdDate(record->nextReplaceRoc);
+        expected += due.isValid() && due >= from && due <= to;
+    }
+    suite.check(QString("due.equivalence.%1").arg(rows), int(qAbs(index.dueBetween(from, to).size() - expected)));
+
+    suite.run("due.query.30d", rows, [&]() {
+        sink += index.dueBetween(from, to).size();
+    });
+    suite.run("due.add_one", rows, [&]() {
+        index.addRecord(records.first());
+    });
+}
+
+void benchPhones(BenchSuite &suite, int rows, const QJsonArray &json) {
+    const QVector<Records::ServiceRecord> records = Records::decodeRows(json);
+    PhoneIndex index;
+    suite.run("phones.build", rows, [&]() {
+        for (const auto &record : records) {
+            index.addRecord(record);
+        }
+        // The first lookup sorts the customers in, so it belongs to the build.
+        sink += index.lookup(QStringLiteral("0"), 1).size();
+    }, [&]() {
+        index.clear();
+    });
+
+    int mismatches = 0;
+    for (const QString &query : {QStringLiteral("0900000"), QStringLiteral("123"), QStringLiteral("0900000123")}) {
+        QSet<QString> expected;
+        for (const auto &record : records) {
+            if (record.phone.startsWith(query) || record.phone.endsWith(query)) {
+                expected.insert(record.phone);
+            }
+        }
+        QSet<QString> found;
+        for (const auto &candidate : index.lookup(query, rows)) {
+            found.insert(candidate.phone);
+        }
+        mismatches += int((expected - found).size() + (found - expected).size());
+    }
+    suite.check(QString("phones.equivalence.%1").arg(rows), mismatches);
+
+    suite.run("phones.lookup.prefix", rows, [&]() {
+        sink += index.lookup(QStringLiteral("09000"), 12).size();
+    });
+    suite.run("phones.lookup.suffix", rows, [&]() {
+        sink += index.lookup(QStringLiteral("0123"), 12).size();
+    });
+}
+
+void benchText(BenchSuite &suite, int rows, const QJsonArray &json) {
+    const QStringList notes = {
+        QStringLiteral("更換RO膜"), QStringLiteral("清洗濾心"), QStringLiteral("更換爐頭"),
+        QStringLiteral("漏水檢修 RO膜 滲漏"), QStringLiteral("櫃體門片調整"), QStringLiteral("更換ROfilter前置")
+    };
+    QVector<Records::ServiceRecord> records = Records::decodeRows(json);
+    qint64 textBytes = 0;
+    for (int i = 0; i < records.size(); ++i) {
+        records[i].notes = QString("%1 第%2筆").arg(notes.at(i % notes.size())).arg(i);
+        records[i].otherItemText = i % 7 == 0 ? QStringLiteral("抽油煙機") : QString();
+        textBytes += RecordSearch::documentText(records.at(i)).size() * qint64(sizeof(QChar));
+    }
+
+    RecordSearch search;
+    suite.run("text.build", rows, [&]() {
+        for (const auto &record : records) {
+            search.add(record);
+        }
+    }, [&]() {
+        search.clear();
+    });
+    suite.recordBytes("text.index_bytes", rows, search.indexStats().approxBytes, textBytes);
+
+    int mismatches = 0;
+    for (const QString &query : {QStringLiteral("RO膜 + 信義路"), QStringLiteral("信義路1號"), QStringLiteral("抽油煙機"),
+                                 QStringLiteral("3號"), QStringLiteral("RO"), QStringLiteral("filter"), QStringLiteral("第12")}) {
+        const QStringList segments = TextIndex::fold(query).split(QRegularExpression("[\\s+]+"), Qt::SkipEmptyParts);
+        int expected = 0;
+        for (const auto &record : records) {
+            const QString text = TextIndex::fold(RecordSearch::documentText(record));
+            expected += std::all_of(segments.cbegin(), segments.cend(), [&text](const QString &segment) {
+                return text.contains(segment);
+            });
+        }
+        int found = 0;
+        search.search(query, 1, &found);
+        mismatches += qAbs(found - expected);
+    }
+    suite.check(QString("text.equivalence.%1").arg(rows), mismatches);
+
+    suite.run("text.query.and", rows, [&]() {
+        sink += search.search(QStringLiteral("RO膜 + 信義路1號"), 500).size();
+    });
+    suite.run("text.query.single", rows, [&]() {
+        sink += search.search(QStringLiteral("抽油煙機"), 500).size();
+    });
+}
+
+void benchColumns(BenchSuite &suite, int rows, const QJsonArray &json) {
+    QVector<Records::ServiceRecord> records = Records::decodeRows(json);
+    qint64 recordBytes = 0;
+    for (int i = 0; i < records.size(); ++i) {
+        // Unique notes, so pooling only saves what real data would let it save.
+        records[i].notes = QString("更換RO膜 第%1筆").arg(i);
+        recordBytes += RecordColumns::approxRecordBytes(records.at(i));
+    }
+
+    RecordColumns columns;
+    suite.run("columns.build", rows, [&]() {
+        for (const auto &record : records) {
+            columns.append(record);
+        }
+    }, [&]() {
+        columns.clear();
+    });
+    if (columns.size() != records.size()) {
+        columns.clear();
+        for (const auto &record : records) {
+            columns.append(record);
+        }
+    }
+    suite.recordBytes("columns.bytes", rows, columns.stats().approxBytes, recordBytes);
+
+    int mismatches = 0;
+    for (int i = 0; i < records.size(); ++i) {
+        const Records::ServiceRecord record = columns.record(i);
+        const Records::ServiceRecord &original = records.at(i);
+        if (Records::displayRow(record, false) != Records::displayRow(original, false) ||
+            record.serviceDay != original.serviceDay || record.createdMs != original.createdMs ||
+            record.itemMask != original.itemMask || record.purposeMask != original.purposeMask ||
+            record.waterCycle != original.waterCycle || record.otherItemText != original.otherItemText) {
+            ++mismatches;
+        }
+    }
+    suite.check(QString("columns.equivalence.%1").arg(rows), mismatches);
+
+    const qint64 waterRows = std::count_if(records.cbegin(), records.cend(), [](const Records::ServiceRecord &record) {
+        return Records::matches(record, true);
+    });
+    suite.check(QString("columns.water.%1").arg(rows), int(qAbs(columns.rowsMatching(true).size() - waterRows)));
+    suite.run("columns.scan.water", rows, [&]() {
+        sink += columns.rowsMatching(true).size();
+    });
+    suite.run("rows.scan.water", rows, [&]() {
+        QVector<int> matched;
+        for (int i = 0; i < records.size(); ++i) {
+            if (Records::matches(records.at(i), true)) {
+                matched.append(i);
+            }
+        }
+        sink += matched.size();
+    });
+    suite.run("columns.materialize", rows, [&]() {
+        for (int i = 0; i < columns.size(); ++i) {
+            sink += columns.record(i).notes.size();
+        }
+    });
+}
+
+void benchExport(BenchSuite &suite, int rows, const QJsonArray &json) {
+    QVector<Records::ServiceRecord> records = Records::decodeRows(json);
+    Records::sortNewestFirst(records);
+    Records::assignWaterRanks(records);
+    const RecordExporter::RowSource source = [&records](const RecordExporter::RowVisitor &visit) {
+        for (const auto &record : records) {
+            if (!visit(record)) {
+                return;
+            }
+        }
+    };
+
+    qint64 sizes[2] = {0, 0};
+    const RecordExporter::Format formats[2] = {RecordExporter::Csv, RecordExporter::Xlsx};
+    for (int i = 0; i < 2; ++i) {
+        const QString name =
+            formats[i] == RecordExporter::Csv ? QStringLiteral("export.csv") : QStringLiteral("export.xlsx");
+        QTemporaryFile file;
+        if (!file.open()) {
+            suite.check(name + ".open", 1);
+            continue;
+        }
+        qint64 written = 0;
+        suite.run(name, rows, [&]() {
+            file.resize(0);
+            file.seek(0);
+            sink += RecordExporter::exportRows(&file, formats[i], false, source, RecordExporter::ProgressHandler(),
+                                               &written);
+        });
+        sizes[i] = file.size();
+        suite.check(QString("%1.rows.%2").arg(name).arg(rows), int(qAbs(written - records.size())));
+        if (formats[i] == RecordExporter::Csv) {
+            file.seek(0);
+            qint64 lines = 0;
+            while (!file.atEnd()) {
+                file.readLine();
+                ++lines;
+            }
+            suite.check(QString("export.csv.lines.%1").arg(rows), int(qAbs(lines - (records.size() + 1))));
+        }
+    }
+    suite.recordBytes("export.csv.bytes", rows, sizes[0], sizes[0]);
+    suite.recordBytes("export.xlsx.bytes", rows, sizes[1], sizes[0]);
+}
+
+void benchImport(BenchSuite &suite, int rows, const QByteArray &body, const QJsonArray &json) {
+    const QStringList keys = {
+        "service_date_roc", "customer_name", "phone", "address", "purposes", "items", "water_replace_cycle",
+        "next_replace_date_roc", "warranty_end_date_roc", "notes", "created_at"
+    };
+    QByteArray csv = keys.join(',').toUtf8() + "\r\n";
+    for (const auto &value : json) {
+        const QJsonObject row = value.toObject();
+        QStringList cells;
+        for (const auto &key : keys) {
+            const QJsonValue cell = row.value(key);
+            cells.append(cell.isArray() ? Records::toStringList(cell).join('/') : cell.toString());
+        }
+        csv += cells.join(',').toUtf8() + "\r\n";
+    }
+
+    const QString importedAt = QStringLiteral("2024-01-01 00:00:00");
+    BulkImporter::Parsed parsed;
+    suite.run("import.csv", rows, [&]() {
+        parsed = BulkImporter::parse(csv, BulkImporter::Csv, importedAt);
+    });
+    suite.check(QString("import.csv.valid.%1").arg(rows), int(qAbs(parsed.records.size() - rows)));
+    suite.run("import.json", rows, [&]() {
+        parsed = BulkImporter::parse(body, BulkImporter::Json, importedAt);
+    });
+    suite.check(QString("import.json.valid.%1").arg(rows), int(qAbs(parsed.records.size() - rows)));
+}
+
+void benchLocal(BenchSuite &suite, int rows, const QJsonArray &json) {
+    QList<QJsonObject> records;
+    QHash<QString, int> expected;
+    for (const auto &value : json) {
+        records.append(value.toObject());
+        ++expected[records.last().value("phone").toString()];
+    }
+    const QStringList phones = expected.keys();
+
+    QTemporaryDir dir;
+    suite.run("local.append", rows, [&]() {
+        LocalBackend backend(dir.path());
+        backend.postRecordsAsync(records, [](const StorageBackend::BatchResult &) {});
+        QCoreApplication::processEvents();
+    }, [&]() {
+        QDir(dir.path()).removeRecursively();
+    });
+
+    // Leaves one copy of the rows for the read benchmarks.
+    {
+        QDir(dir.path()).removeRecursively();
+        LocalBackend backend(dir.path());
+        backend.postRecordsAsync(records, [](const StorageBackend::BatchResult &) {});
+        QCoreApplication::processEvents();
+    }
+
+    suite.run("local.open", rows, [&]() {
+        LocalBackend backend(dir.path());
+        sink += backend.stats().records;
+    });
+    suite.run("local.open.rebuild", rows, [&]() {
+        LocalBackend backend(dir.path());
+        sink += backend.stats().records;
+    }, [&]() {
+        QFile::remove(dir.path() + "/index.bin");
+    });
+
+    LocalBackend backend(dir.path());
+    int mismatches = 0;
+    for (const auto &phone : phones) {
+        backend.fetchRawAsync(phone, [&mismatches, &expected, phone](const StorageBackend::Result &result) {
+            mismatches += !result.ok || result.rows.size() != expected.value(phone);
+        });
+    }
+    QCoreApplication::processEvents();
+    suite.check(QString("local.equivalence.%1").arg(rows), mismatches);
+    suite.run("local.lookup.all_customers", rows, [&]() {
+        for (const auto &phone : phones) {
+            backend.fetchRawAsync(phone, [](const StorageBackend::Result &result) {
+                sink += result.rows.size();
+            });
+        }
+        QCoreApplication::processEvents();
+    });
+    qint64 synced = 0;
+    suite.run("local.sync_pages", rows, [&]() {
+        QString cursor;
+        bool more = true;
+        synced = 0;
+        while (more) {
+            more = false;
+            backend.fetchSyncPageAsync(cursor, 500, [&](const StorageBackend::Result &result) {
+                more = result.hasMore && !result.rows.isEmpty();
+                cursor = result.cursor;
+                synced += result.rows.size();
+            });
+            QCoreApplication::processEvents();
+        }
+    });
+    if (suite.enabled("local.sync_pages")) {
+        suite.check(QString("local.sync_rows.%1").arg(rows), int(qAbs(synced - records.size())));
+    }
+
+    // The store's date index must list exactly what DueIndex lists for the same records.
+    DueIndex index;
+    for (const auto &record : Records::decodeRows(json)) {
+        index.addRecord(record);
+    }
+    const auto describe = [](const QVector<DueIndex::Entry> &entries) {
+        QStringList lines;
+        for (const auto &entry : entries) {
+            lines.append(QStringList{QString::number(entry.dueDay), QString::number(entry.kind), entry.dueRoc, entry.serviceDateRoc,
+                                     entry.customerName, entry.phone, entry.address}.join('|'));
+        }
+        std::sort(lines.begin(), lines.end());
+        return lines;
+    };
+    const QStringList wanted = describe(index.dueBetween(QDate(), QDate()));
+    const QStringList listed = describe(backend.dueBetween(QDate(), QDate()));
+    int dueMismatches = int(qAbs(wanted.size() - listed.size()));
+    for (int i = 0; i < qMin(wanted.size(), listed.size()); ++i) {
+        dueMismatches += wanted.at(i) != listed.at(i);
+    }
+    suite.check(QString("local.due.equivalence.%1").arg(rows), dueMismatches);
+    const QDate from(2020, 5, 15);
+    suite.run("local.due.query.30d", rows, [&]() {
+        sink += backend.dueBetween(from, from.addDays(30)).size();
+    });
+}
+
+void benchPerf(BenchSuite &suite, int rows) {
+    const bool wasEnabled = Perf::enabled();
+    Perf::setEnabled(false);
+    suite.run("perf.scope.off", rows, [&]() {
+        for (int i = 0; i < rows; ++i) {
+            Perf::Scope scope("bench.scope");
+        }
+    });
+    Perf::setEnabled(true);
+    suite.run("perf.scope.on", rows, [&]() {
+        for (int i = 0; i < rows; ++i) {
+            Perf::Scope scope("bench.scope");
+        }
+    });
+    Perf::setEnabled(wasEnabled);
+    Perf::reset();
+}
+
+void benchDates(BenchSuite &suite, int rows) {
+    const QStringList corpus = SyntheticData::dateCorpus(rows);
+    QVector<QDate> dates;
+    dates.reserve(corpus.size());
+    for (const auto &text : corpus) {
+        dates.append(Legacy::parseYmd(text).isValid() ? Legacy::parseYmd(text) : Legacy::rocToAdDate(text));
+    }
+
+    int mismatches = 0;
+    for (int i = 0; i < corpus.size(); ++i) {
+        const QString &text = corpus.at(i);
+        const QDate &date = dates.at(i);
+        const bool same = Legacy::isYmd(text) == DateUtils::isYmd(text)
+            && Legacy::parseYmd(text) == DateUtils::parseYmd(text)
+            && Legacy::dateToIso(date) == DateUtils::dateToIso(date)
+            && Legacy::dateToRoc(date) == DateUtils::dateToRoc(date)
+            && Legacy::normalizeRocStr(text) == DateUtils::normalizeRocStr(text)
+            && Legacy::rocToAdDate(text) == DateUtils::rocToAdDate(text);
+        if (!same) {
+            ++mismatches;
+            std::fprintf(stderr, "dates mismatch: \"%s\"\n", text.toUtf8().constData());
+        }
+    }
+    suite.check(QString("dates.equivalence.%1").arg(rows), mismatches);
+
+    suite.run("dates.isYmd.legacy", rows, [&]() {
+        for (const auto &text : corpus) {
+            sink += Legacy::isYmd(text);
+        }
+    });
+    suite.run("dates.isYmd", rows, [&]() {
+        for (const auto &text : corpus) {
+            sink += DateUtils::isYmd(text);
+        }
+    });
+    suite.run("dates.parseYmd.legacy", rows, [&]() {
+        for (const auto &text : corpus) {
+            sink += Legacy::parseYmd(text).day();
+        }
+    });
+    suite.run("dates.parseYmd", rows, [&]() {
+        for (const auto &text : corpus) {
+            sink += DateUtils::parseYmd(text).day();
+        }
+    });
+    suite.run("dates.normalizeRocStr.legacy", rows, [&]() {
+        for (const auto &text : corpus) {
+            sink += Legacy::normalizeRocStr(text).size();
+        }
+    });
+    suite.run("dates.normalizeRocStr", rows, [&]() {
+        for (const auto &text : corpus) {
+            sink += DateUtils::normalizeRocStr(text).size();
+        }
+    });
+    suite.run("dates.rocToAdDate.legacy", rows, [&]() {
+        for (const auto &text : corpus) {
+            sink += Legacy::rocToAdDate(text).day();
+        }
+    });
+    suite.run("dates.rocToAdDate", rows, [&]() {
+        for (const auto &text : corpus) {
+            sink += DateUtils::rocToAdDate(text).day();
+        }
+    });
+    suite.run("dates.rocToAdDates", rows, [&]() {
+        sink += DateUtils::rocToAdDates(corpus).size();
+    });
+    suite.run("dates.dateToIso.legacy", rows, [&]() {
+        for (const auto &date : dates) {
+            sink += Legacy::dateToIso(date).size();
+        }
+    });
+    suite.run("dates.dateToIso", rows, [&]() {
+        for (const auto &date : dates) {
+            sink += DateUtils::dateToIso(date).size();
+        }
+    });
+    suite.run("dates.dateToRoc.legacy", rows, [&]() {
+        for (const auto &date : dates) {
+            sink += Legacy::dateToRoc(date).size();
+        }
+    });
+    suite.run("dates.dateToRoc", rows, [&]() {
+        for (const auto &date : dates) {
+            sink += DateUtils::dateToRoc(date).size();
+        }
+    });
+    suite.run("dates.datesToRoc", rows, [&]() {
+        sink += DateUtils::datesToRoc(dates).size();
+    });
+    suite.run("dates.addMonths", rows, [&]() {
+        for (const auto &date : dates) {
+            sink += DateUtils::addMonths(date, 18).day();
+        }
+    });
+    suite.run("dates.addOneYear", rows, [&]() {
+        for (const auto &date : dates) {
+            sink += DateUtils::addOneYear(date).day();
+        }
+    });
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Maintenance Log data-path benchmarks");
+    parser.addHelpOption();
+    QCommandLineOption rowsOption("rows", "Comma-separated result-set sizes.", "sizes", "1000,10000,100000");
+    QCommandLineOption iterationsOption("iterations", "Samples per benchmark.", "count", "5");
+    QCommandLineOption outputOption("output", "Write JSON results to this file instead of stdout.", "path");
+    QCommandLineOption filterOption("filter", "Only run benchmarks whose name contains this text.", "text");
+    parser.addOptions({rowsOption, iterationsOption, outputOption, filterOption});
+    parser.process(app);
+
+    BenchSuite::Options options;
+    for (const auto &size : parser.value(rowsOption).split(',', Qt::SkipEmptyParts)) {
+        if (size.toInt() > 0) {
+            options.sizes.append(size.toInt());
+        }
+    }
+    options.iterations = qMax(1, parser.value(iterationsOption).toInt());
+    options.outputPath = parser.value(outputOption);
+    options.filter = parser.value(filterOption);
+
+    BenchSuite suite(options);
+    for (int rows : options.sizes) {
+        const QByteArray body = SyntheticData::buildBody(rows);
+        const QJsonArray json = ApiClient::parseJsonResult(body, true, QString()).rows;
+        benchParse(suite, rows, body);
+        benchWire(suite, rows, body, json);
+        benchRows(suite, rows, json);
+        benchTable(suite, rows, json);
+        benchStalls(suite, rows, json);
+        benchDue(suite, rows, json);
+        benchPhones(suite, rows, json);
+        benchText(suite, rows, json);
+        benchColumns(suite, rows, json);
+        benchExport(suite, rows, json);
+        benchImport(suite, rows, body, json);
+        benchLocal(suite, rows, json);
+        benchPerf(suite, rows);
+        benchDates(suite, rows);
+    }
+
+    if (!suite.writeResults()) {
+        return 2;
+    }
+    return suite.failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+#include "BenchSuite.h"
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSysInfo>
+
+#include <algorithm>
+#include <cstdio>
+
+BenchSuite::BenchSuite(const Options &options) : settings(options) {}
+
+const BenchSuite::Options &BenchSuite::options() const {
+    return settings;
+}
+
+bool BenchSuite::enabled(const QString &name) const {
+    return settings.filter.isEmpty() || name.contains(settings.filter);
+}
+
+void BenchSuite::run(const QString &name, int rows, const std::function<void()> &body, const std::function<void()> &setup) {
+    if (!enabled(name)) {
+        return;
+    }
+    QVector<double> samples;
+    for (int i = 0; i < settings.iterations; ++i) {
+        if (setup) {
+            setup();
+        }
+        QElapsedTimer timer;
+        timer.start();
+        body();
+        samples.append(timer.nsecsElapsed() / 1e6);
+    }
+    record(name, rows, samples);
+}
+
+void BenchSuite::record(const QString &name, int rows, const QVector<double> &samplesMs) {
+    if (!enabled(name) || samplesMs.isEmpty()) {
+        return;
+    }
+    QVector<double> sorted = samplesMs;
+    std::sort(sorted.begin(), sorted.end());
+    double total = 0;
+    for (double sample : sorted) {
+        total += sample;
+    }
+
+    QJsonObject result;
+    result.insert("name", name);
+    result.insert("rows", rows);
+    result.insert("iterations", int(sorted.size()));
+    result.insert("median_ms", sorted.at(sorted.size() / 2));
+    result.insert("min_ms", sorted.first());
+    result.insert("max_ms", sorted.last());
+    result.insert("mean_ms", total / sorted.size());
+    results.append(result);
+
+    std::fprintf(stderr, "%-28s rows=%-8d median_ms=%10.3f min_ms=%10.3f\n",
+                 name.toUtf8().constData(), rows, sorted.at(sorted.size() / 2), sorted.first());
+}
+
+void BenchSuite::recordBytes(const QString &name, int rows, qint64 bytes, qint64 baselineBytes) {
+    if (!enabled(name)) {
+        return;
+    }
+    const double ratio = baselineBytes > 0 ? double(bytes) / baselineBytes : 1.0;
+    QJsonObject result;
+    result.insert("name", name);
+    result.insert("rows", rows);
+    result.insert("bytes", bytes);
+    result.insert("ratio", ratio);
+    results.append(result);
+
+    std::fprintf(stderr, "%-28s rows=%-8d bytes=%12lld ratio=%6.3f\n",
+                 name.toUtf8().constData(), rows, static_cast<long long>(bytes), ratio);
+}
+
+void BenchSuite::check(const QString &name, int failures) {
+    QJsonObject result;
+    result.insert("name", name);
+    result.insert("failures", failures);
+    checks.append(result);
+    failureCount += failures;
+    std::fprintf(stderr, "%-28s failures=%d\n", name.toUtf8().constData(), failures);
+}
+
+bool BenchSuite::writeResults() const {
+    QJsonObject root;
+    root.insert("suite", "MaintenanceLogBench");
+    root.insert("timestamp", QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+    root.insert("qt_version", QString::fromLatin1(qVersion()));
+    root.insert("cpu_architecture", QSysInfo::currentCpuArchitecture());
+    root.insert("os", QSysInfo::prettyProductName());
+    root.insert("iterations", settings.iterations);
+    root.insert("results", results);
+    root.insert("checks", checks);
+    const QByteArray json = QJsonDocument(root).toJson();
+
+    if (settings.outputPath.isEmpty()) {
+        std::fwrite(json.constData(), 1, json.size(), stdout);
+        return true;
+    }
+    QFile file(settings.outputPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        std::fprintf(stderr, "cannot write %s\n", settings.outputPath.toUtf8().constData());
+        return false;
+    }
+    return file.write(json) == json.size();
+}
+
+int BenchSuite::failures() const {
+    return failureCount;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <QJsonArray>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+#include <functional>
+
+class BenchSuite {
+public:
+    struct Options {
+        QList<int> sizes;
+        int iterations = 5;
+        QString outputPath;
+        QString filter;
+    };
+
+    explicit BenchSuite(const Options &options);
+
+    const Options &options() const;
+    bool enabled(const QString &name) const;
+
+    void run(const QString &name, int rows, const std::function<void()> &body,
+             const std::function<void()> &setup = std::function<void()>());
+    void record(const QString &name, int rows, const QVector<double> &samplesMs);
+    void recordBytes(const QString &name, int rows, qint64 bytes, qint64 baselineBytes);
+    void check(const QString &name, int failures);
+
+    bool writeResults() const;
+    int failures() const;
+
+private:
+    Options settings;
+    QJsonArray results;
+    QJsonArray checks;
+    int failureCount = 0;
+};
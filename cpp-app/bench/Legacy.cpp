@@ -0,0 +1,147 @@
+#include "Legacy.h"
+
+#include <QDateTime>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QVector>
+
+#include <algorithm>
+
+#include "Records.h"
+
+namespace Legacy {
+
+bool isYmd(const QString &text) {
+    static const QRegularExpression re(R"(\d{4}-\d{2}-\d{2})");
+    return re.match(text.trimmed()).hasMatch();
+}
+
+QDate parseYmd(const QString &text) {
+    if (!isYmd(text)) {
+        return {};
+    }
+    return QDate::fromString(text.trimmed(), "yyyy-MM-dd");
+}
+
+QString dateToIso(const QDate &date) {
+    if (!date.isValid()) {
+        return {};
+    }
+    return date.toString("yyyy-MM-dd");
+}
+
+QString dateToRoc(const QDate &date) {
+    if (!date.isValid()) {
+        return {};
+    }
+    int rocYear = date.year() - 1911;
+    return QString("%1.%2.%3")
+        .arg(rocYear, 3, 10, QChar('0'))
+        .arg(date.month(), 2, 10, QChar('0'))
+        .arg(date.day(), 2, 10, QChar('0'));
+}
+
+QString normalizeRocStr(const QString &value) {
+    QString trimmed = value.trimmed();
+    if (trimmed.isEmpty()) {
+        return {};
+    }
+    static const QRegularExpression re(R"(^\s*(\d{1,3})[./-](\d{1,2})[./-](\d{1,2})\s*$)");
+    auto match = re.match(trimmed);
+    if (!match.hasMatch()) {
+        return {};
+    }
+    return QString("%1.%2.%3")
+        .arg(match.captured(1).toInt(), 3, 10, QChar('0'))
+        .arg(match.captured(2).toInt(), 2, 10, QChar('0'))
+        .arg(match.captured(3).toInt(), 2, 10, QChar('0'));
+}
+
+QDate rocToAdDate(const QString &rocStr) {
+    const QStringList parts = normalizeRocStr(rocStr).split('.');
+    if (parts.size() != 3) {
+        return {};
+    }
+    return QDate(parts[0].toInt() + 1911, parts[1].toInt(), parts[2].toInt());
+}
+
+QList<QStringList> displayRows(const QJsonArray &rows, bool onlyWater) {
+    struct Record {
+        QJsonObject obj;
+        QDate rocDate;
+        QDateTime createdAt;
+    };
+
+    QVector<Record> records;
+    records.reserve(rows.size());
+    for (const auto &value : rows) {
+        if (!value.isObject()) {
+            continue;
+        }
+        QJsonObject obj = value.toObject();
+        QString normalized = normalizeRocStr(obj.value("service_date_roc").toString());
+        QDate rocDate = rocToAdDate(normalized);
+        QDateTime createdAt = QDateTime::fromString(obj.value("created_at").toString(), "yyyy-MM-dd HH:mm:ss");
+        records.push_back({obj, rocDate, createdAt});
+    }
+
+    std::sort(records.begin(), records.end(), [](const Record &a, const Record &b) {
+        if (a.rocDate != b.rocDate) {
+            return a.rocDate > b.rocDate;
+        }
+        return a.createdAt > b.createdAt;
+    });
+
+    QVector<int> waterIndices;
+    for (int i = 0; i < records.size(); ++i) {
+        if (Records::toStringList(records[i].obj.value("items")).contains(Records::kWaterItem)) {
+            waterIndices.append(i);
+        }
+    }
+
+    QList<QStringList> displayRows;
+    for (int i = 0; i < records.size(); ++i) {
+        const QJsonObject &obj = records[i].obj;
+        QStringList purposes = Records::toStringList(obj.value("purposes"));
+        QStringList items = Records::toStringList(obj.value("items"));
+        if (onlyWater && !items.contains(Records::kWaterItem)) {
+            continue;
+        }
+
+        QString nextReplace = obj.value("next_replace_date_roc").toString().trimmed();
+        QString warrantyEnd = obj.value("warranty_end_date_roc").toString().trimmed();
+        QString followup;
+        if (onlyWater) {
+            followup = nextReplace.isEmpty() ? QString() : QString("更換：%1").arg(nextReplace);
+        } else if (!nextReplace.isEmpty() && !warrantyEnd.isEmpty()) {
+            followup = QString("更換：%1 / 保固：%2").arg(nextReplace, warrantyEnd);
+        } else if (!nextReplace.isEmpty()) {
+            followup = QString("更換：%1").arg(nextReplace);
+        } else if (!warrantyEnd.isEmpty()) {
+            followup = QString("保固：%1").arg(warrantyEnd);
+        }
+
+        QString waterStatus;
+        int waterIndex = waterIndices.indexOf(i);
+        if (waterIndex == 0) {
+            waterStatus = "未更換";
+        } else if (waterIndex > 0) {
+            waterStatus = "已更換";
+        }
+
+        displayRows.append({
+            normalizeRocStr(obj.value("service_date_roc").toString()),
+            obj.value("customer_name").toString(),
+            obj.value("phone").toString(),
+            obj.value("address").toString(),
+            Records::joinList(purposes),
+            onlyWater ? Records::kWaterItem : Records::joinList(items),
+            waterStatus,
+            followup,
+            obj.value("notes").toString()
+        });
+    }
+    return displayRows;
+}
+
+} // namespace Legacy
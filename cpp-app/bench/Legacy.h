@@ -0,0 +1,18 @@
+#pragma once
+
+#include <QDate>
+#include <QJsonArray>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+namespace Legacy {
+bool isYmd(const QString &text);
+QDate parseYmd(const QString &text);
+QString dateToIso(const QDate &date);
+QString dateToRoc(const QDate &date);
+QString normalizeRocStr(const QString &value);
+QDate rocToAdDate(const QString &rocStr);
+
+QList<QStringList> displayRows(const QJsonArray &rows, bool onlyWater);
+} // namespace Legacy
@@ -0,0 +1,59 @@
+#include "SyntheticData.h"
+
+#include <QDate>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QString>
+
+#include "Legacy.h"
+
+namespace SyntheticData {
+
+QByteArray buildBody(int rowCount) {
+    QJsonArray rows;
+    for (int i = 0; i < rowCount; ++i) {
+        const int year = 100 + i % 14;
+        QJsonObject row;
+        row.insert("service_date_roc", QString("%1.%2.%3").arg(year).arg(i % 12 + 1, 2, 10, QChar('0')).arg(i % 28 + 1, 2, 10, QChar('0')));
+        row.insert("customer_name", QString("客戶%1").arg(i % 500));
+        row.insert("phone", QString("09%1").arg(i % 500, 8, 10, QChar('0')));
+        row.insert("address", QString("台北市信義區信義路%1號").arg(i % 300));
+        row.insert("purposes", QJsonArray{QStringLiteral("安裝")});
+        row.insert("items", i % 3 == 0 ? QJsonArray{QStringLiteral("淨水設備")} : QJsonArray{QStringLiteral("瓦斯爐具器具"), QStringLiteral("系統櫃廚具")});
+        row.insert("water_replace_cycle", i % 3 == 0 ? QStringLiteral("一年") : QString());
+        row.insert("next_replace_date_roc", i % 3 == 0 ? QString("%1.06.01").arg(year + 1) : QString());
+        row.insert("warranty_end_date_roc", i % 3 == 0 ? QString() : QString("%1.06.01").arg(year + 1));
+        row.insert("notes", QStringLiteral("更換RO膜"));
+        row.insert("created_at", QString("20%1-01-01 10:00:00").arg(year - 89));
+        rows.append(row);
+    }
+    QJsonObject root;
+    root.insert("ok", true);
+    root.insert("rows", rows);
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+QStringList dateCorpus(int count) {
+    const QString alphabet = QStringLiteral("0123456789./- x\u0661");
+    QStringList corpus = {
+        "2024-02-29", " 2024-02-30 ", "x2024-01-011", "113.1.5", "113/01/05", " 99-12-31 ",
+        "1130.01.05", "113.001.05", "113..05", "", "  ", "0000-00-00", "\u0661\u0661\u0663.01.05", "\uff12\uff10\uff12\uff14-01-01"
+    };
+    QRandomGenerator rng(20240101);
+    while (corpus.size() < count) {
+        QString text;
+        const int length = rng.bounded(13);
+        for (int j = 0; j < length; ++j) {
+            text += alphabet.at(rng.bounded(int(alphabet.size())));
+        }
+        corpus.append(text);
+        const QDate date = QDate(1912, 1, 1).addDays(rng.bounded(60000));
+        corpus.append(Legacy::dateToIso(date));
+        corpus.append(Legacy::dateToRoc(date));
+    }
+    return corpus;
+}
+
+} // namespace SyntheticData
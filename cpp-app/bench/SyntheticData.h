@@ -0,0 +1,9 @@
+#pragma once
+
+#include <QByteArray>
+#include <QStringList>
+
+namespace SyntheticData {
+QByteArray buildBody(int rowCount);
+QStringList dateCorpus(int count);
+} // namespace SyntheticData
@@ -1,32 +1,277 @@
 #include "ApiClient.h"
 
 #include <QDateTime>
+#include <QElapsedTimer>
+#include <QHostInfo>
 #include <QJsonDocument>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QNetworkRequest>
+#include <QPair>
+#include <QTimer>
 #include <QUrlQuery>
+#include <QtConcurrent/QtConcurrentRun>
+#if QT_CONFIG(ssl)
+#include <QSslConfiguration>
+#endif
+
+#include "Compression.h"
+#include "JsonRowStream.h"
+#include "Perf.h"
 
 namespace {
 const char *kEndpointUrl =
     "https://script.google.com/macros/s/AKfycbyyHjCS0qBVtI4jDD9HiqT2kRnMV6U0pOQLUT68kRMlp2i7A1KAqtu1CwFT1DGiq58W/exec";
+
+const int kMaxBatchRecords = 200;
+const int kMaxBatchBytes = 256 * 1024;
+
+const qint64 kRewarmIdleMs = 60 * 1000;
+const qint64 kRefreshWindowSecs = 60;
+const int kMinCompressBytes = 1024;
+const qint64 kMaxDecompressedBytes = 512LL * 1024 * 1024;
+const char *kAppsScriptHost = "script.google.com";
+const char *kAppsScriptContentOrigin = "https://script.googleusercontent.com";
+
+QString originOf(const QUrl &url) {
+    return url.adjusted(QUrl::RemoveUserInfo | QUrl::RemovePath | QUrl::RemoveQuery | QUrl::RemoveFragment).toString();
+}
+
+struct ReplyTiming {
+    QElapsedTimer timer;
+    QUrl url;
+    qint64 hopStart = -1;
+    qint64 handshakeMs = 0;
+    qint64 firstByteMs = -1;
+    qint64 wireBytes = 0;
+    bool newConnection = false;
+    int redirects = 0;
+};
+
+// Parser state lives on the decode pool; only `streaming` is touched on the GUI thread.
+struct RowStreamState {
+    JsonRowStream parser;
+    bool streaming = false;
+};
 } // namespace
 
-ApiClient::ApiClient(QObject *parent) : QObject(parent) {}
+struct ApiClient::FetchOutcome {
+    Result result;
+    QJsonArray tail;
+};
+
+struct ApiClient::PendingFetch {
+    struct Subscriber {
+        Ticket ticket = 0;
+        ResultHandler handler;
+        RowsHandler onRows;
+    };
+
+    QList<Subscriber> subscribers;
+    // The only copy of the rows parsed so far: late subscribers start from it, and the result and cache entry share it.
+    QJsonArray rows;
+    std::shared_ptr<RowStreamState> stream;
+    QNetworkReply *reply = nullptr;
+
+    void deliverRows(const QJsonArray &chunk) const {
+        const QList<Subscriber> current = subscribers;
+        for (const auto &subscriber : current) {
+            if (subscriber.onRows) {
+                subscriber.onRows(chunk);
+            }
+        }
+    }
+};
+
+struct ApiClient::BatchState {
+    QList<QJsonObject> records;
+    QList<QByteArray> encoded;
+    QList<Result> results;
+    QList<QPair<int, int>> chunks;
+    BatchHandler handler;
+    QString error;
+};
+
+ApiClient::ApiClient(QObject *parent) : StorageBackend(parent), endpoint(QString::fromUtf8(kEndpointUrl)) {
+    const QString overrideUrl = qEnvironmentVariable("MAINTENANCE_LOG_ENDPOINT");
+    if (!overrideUrl.isEmpty()) {
+        endpoint = overrideUrl;
+    }
+    batchPost = qEnvironmentVariableIntValue("MAINTENANCE_LOG_BATCH_POST") != 0;
+    gzipRequests = qEnvironmentVariableIntValue("MAINTENANCE_LOG_GZIP_REQUESTS") != 0;
+
+    if (QUrl(endpoint).host() == QLatin1String(kAppsScriptHost)) {
+        redirectOrigins.insert(QString::fromUtf8(kAppsScriptContentOrigin));
+    }
+    decodePool.setMaxThreadCount(1);
+    QTimer::singleShot(0, this, &ApiClient::warmUp);
+}
 
 QString ApiClient::endpointUrl() {
-    return QString::fromUtf8(kEndpointUrl);
+    return redirectedEndpoint.isEmpty() ? endpoint : redirectedEndpoint;
+}
+
+void ApiClient::setEndpointUrl(const QString &url) {
+    endpoint = url;
+    redirectedEndpoint.clear();
+}
+
+void ApiClient::setBatchPostEnabled(bool enabled) {
+    batchPost = enabled;
+}
+
+bool ApiClient::batchPostEnabled() const {
+    return batchPost;
 }
 
-void ApiClient::sendPostAsync(const QJsonObject &payload, ResultHandler handler) {
-    QNetworkRequest request(QUrl(endpointUrl()));
+void ApiClient::setRequestCompressionEnabled(bool enabled) {
+    gzipRequests = enabled;
+}
+
+bool ApiClient::requestCompressionEnabled() const {
+    return gzipRequests;
+}
+
+QNetworkRequest ApiClient::makeRequest(const QUrl &url) const {
+    QNetworkRequest request(url);
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+    request.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::NoLessSafeRedirectPolicy);
+    // Qt negotiates Accept-Encoding and inflates responses itself; raise its decompression-bomb limit for long histories.
+    request.setDecompressedSafetyCheckThreshold(kMaxDecompressedBytes);
+    return request;
+}
+
+QNetworkReply *ApiClient::postJson(const QByteArray &body) {
+    QNetworkRequest request = makeRequest(QUrl(endpointUrl()));
     request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
 
-    QNetworkReply *reply = manager.post(request, QJsonDocument(payload).toJson());
-    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, handler]() {
+    QByteArray wireBody = body;
+    if (gzipRequests && body.size() >= kMinCompressBytes) {
+        const QByteArray compressed = Compression::gzip(body);
+        if (!compressed.isEmpty() && compressed.size() < body.size()) {
+            request.setRawHeader("Content-Encoding", "gzip");
+            wireBody = compressed;
+        }
+    }
+    netStats.bytesSent += body.size();
+    netStats.wireBytesSent += wireBody.size();
+
+    QNetworkReply *reply = manager.post(request, wireBody);
+    trackReply(reply);
+    return reply;
+}
+
+QByteArray ApiClient::readBody(QNetworkReply *reply) {
+    const QByteArray body = reply->readAll();
+    netStats.bytesReceived += body.size();
+    return body;
+}
+
+void ApiClient::warmUp() {
+    if (lastActivity.isValid() && lastActivity.elapsed() < kRewarmIdleMs) {
+        return;
+    }
+    lastActivity.start();
+    preconnect(QUrl(endpointUrl()));
+    for (const auto &origin : std::as_const(redirectOrigins)) {
+        preconnect(QUrl(origin));
+    }
+}
+
+void ApiClient::preconnect(const QUrl &url) {
+    if (url.host().isEmpty()) {
+        return;
+    }
+
+    // Resolve first so the socket below finds the name in Qt's host cache.
+    QElapsedTimer timer;
+    timer.start();
+    QHostInfo::lookupHost(url.host(), this, [this, url, timer](const QHostInfo &info) {
+        if (info.error() != QHostInfo::NoError) {
+            return;
+        }
+        netStats.dnsMs = timer.elapsed();
+        if (url.scheme() != QLatin1String("https")) {
+            manager.connectToHost(url.host(), url.port(80));
+            return;
+        }
+#if QT_CONFIG(ssl)
+        QSslConfiguration ssl = QSslConfiguration::defaultConfiguration();
+        ssl.setAllowedNextProtocols({QSslConfiguration::ALPNProtocolHTTP2, QSslConfiguration::NextProtocolHttp1_1});
+        manager.connectToHostEncrypted(url.host(), url.port(443), ssl);
+#endif
+    });
+}
+
+void ApiClient::trackReply(QNetworkReply *reply) {
+    lastActivity.start();
+    auto timing = std::make_shared<ReplyTiming>();
+    timing->timer.start();
+    timing->url = reply->url();
+
+    const auto endHandshake = [timing]() {
+        if (timing->hopStart >= 0) {
+            timing->handshakeMs += timing->timer.elapsed() - timing->hopStart;
+            timing->hopStart = -1;
+        }
+    };
+    QObject::connect(reply, &QNetworkReply::socketStartedConnecting, this, [timing]() {
+        timing->newConnection = true;
+        timing->hopStart = timing->timer.elapsed();
+    });
+    QObject::connect(reply, &QNetworkReply::encrypted, this, endHandshake);
+    QObject::connect(reply, &QNetworkReply::requestSent, this, endHandshake);
+
+    QObject::connect(reply, &QNetworkReply::redirected, this, [this, reply, timing](const QUrl &target) {
+        ++timing->redirects;
+        redirectOrigins.insert(originOf(target));
+
+        const int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        const bool permanent = statusCode == 301 || statusCode == 308;
+        if (permanent && timing->url.adjusted(QUrl::RemoveQuery) == QUrl(endpointUrl())
+            && timing->url.query() == target.query()) {
+            redirectedEndpoint = target.adjusted(QUrl::RemoveQuery).toString();
+        }
+        timing->url = target;
+    });
+
+    QObject::connect(reply, &QNetworkReply::readyRead, this, [timing]() {
+        if (timing->firstByteMs < 0) {
+            timing->firstByteMs = timing->timer.elapsed();
+        }
+    });
+    // Counts the body as it arrived, before Qt inflates it; an inflated reply no longer carries Content-Length.
+    QObject::connect(reply, &QNetworkReply::downloadProgress, this, [timing](qint64 received, qint64) {
+        timing->wireBytes = received;
+    });
+
+    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, timing]() {
+        lastActivity.start();
+        netStats.wireBytesReceived += timing->wireBytes;
+        if (reply->error() != QNetworkReply::NoError) {
+            return;
+        }
+        ++netStats.requests;
+        netStats.redirects += timing->redirects;
+        if (timing->newConnection) {
+            ++netStats.newConnections;
+            handshakeMsTotal += timing->handshakeMs;
+        }
+        if (reply->attribute(QNetworkRequest::Http2WasUsedAttribute).toBool()) {
+            ++netStats.http2Requests;
+        }
+        firstByteMsTotal += timing->firstByteMs >= 0 ? timing->firstByteMs : timing->timer.elapsed();
+    });
+}
+
+void ApiClient::sendPostAsync(const QJsonObject &payload, bool requireJson, ResultHandler handler) {
+    const qint64 startNs = Perf::nowNs();
+    QNetworkReply *reply = postJson(QJsonDocument(payload).toJson(QJsonDocument::Compact));
+    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, requireJson, handler, startNs]() {
+        Perf::record("api.post", startNs, Perf::nowNs() - startNs);
         const int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
         const QString contentType = reply->header(QNetworkRequest::ContentTypeHeader).toString().toLower();
-        const QByteArray body = reply->readAll();
+        const QByteArray body = readBody(reply);
         const QString error = reply->error() == QNetworkReply::NoError ? QString() : reply->errorString();
         reply->deleteLater();
 
@@ -42,6 +287,11 @@ void ApiClient::sendPostAsync(const QJsonObject &payload, ResultHandler handler)
             return;
         }
 
+        // A login or error page also arrives as a 200; callers that delete the record afterwards cannot take that as success.
+        if (!contentType.contains("application/json") && requireJson) {
+            handler(buildErrorResult(QString::fromUtf8("❌ 回應非JSON（可能權限/網址錯）\n%1").arg(QString::fromUtf8(body.left(200)))));
+            return;
+        }
         if (!contentType.contains("application/json")) {
             Result result;
             result.ok = true;
@@ -55,88 +305,482 @@ void ApiClient::sendPostAsync(const QJsonObject &payload, ResultHandler handler)
     });
 }
 
-void ApiClient::sendGetAsync(const QUrl &url, ResultHandler handler) {
-    QNetworkRequest request(url);
+void ApiClient::sendGetAsync(const QUrl &url, const QString &cacheKey, Ticket ticket, ResultHandler handler, RowsHandler onRows) {
+    const QString fetchKey = url.toString();
+    ticketFetchKeys.insert(ticket, fetchKey);
+    auto pending = pendingFetches.value(fetchKey);
+    if (pending) {
+        if (onRows && !pending->rows.isEmpty()) {
+            onRows(pending->rows);
+        }
+        pending->subscribers.append({ticket, handler, onRows});
+        return;
+    }
+
+    pending = std::make_shared<PendingFetch>();
+    pending->subscribers.append({ticket, handler, onRows});
+    pending->stream = std::make_shared<RowStreamState>();
+    pendingFetches.insert(fetchKey, pending);
+
+    QNetworkRequest request = makeRequest(url);
 
+    QElapsedTimer timer;
+    timer.start();
+    const qint64 startNs = Perf::nowNs();
     QNetworkReply *reply = manager.get(request);
-    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, handler]() {
+    trackReply(reply);
+    pending->reply = reply;
+    auto stream = pending->stream;
+
+    QObject::connect(reply, &QNetworkReply::readyRead, this, [this, reply, stream, pending]() {
+        if (!stream->streaming) {
+            const int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+            const QString contentType = reply->header(QNetworkRequest::ContentTypeHeader).toString().toLower();
+            if (statusCode != 200 || !contentType.contains("application/json")) {
+                return;
+            }
+            stream->streaming = true;
+        }
+
+        const QByteArray bytes = readBody(reply);
+        QtConcurrent::run(&decodePool, [stream, bytes]() {
+            Perf::Scope scope("api.parse.chunk");
+            QJsonArray chunk;
+            stream->parser.feed(bytes, &chunk);
+            return chunk;
+        }).then(this, [pending](const QJsonArray &chunk) {
+            if (chunk.isEmpty()) {
+                return;
+            }
+            for (const auto &row : chunk) {
+                pending->rows.append(row);
+            }
+            pending->deliverRows(chunk);
+        });
+    });
+
+    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, fetchKey, pending, cacheKey, timer, stream, startNs]() {
+        Perf::record("api.network", startNs, Perf::nowNs() - startNs);
+        if (pendingFetches.value(fetchKey) == pending) {
+            pendingFetches.remove(fetchKey);
+        }
+
         const int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
         const QString contentType = reply->header(QNetworkRequest::ContentTypeHeader).toString().toLower();
-        const QByteArray body = reply->readAll();
+        const QByteArray body = readBody(reply);
         const QString error = reply->error() == QNetworkReply::NoError ? QString() : reply->errorString();
+        const qint64 fetchMs = timer.elapsed();
         reply->deleteLater();
 
-        if (!error.isEmpty()) {
-            handler(buildErrorResult(QString::fromUtf8("❌ 連線失敗：%1").arg(error)));
+        // Queued behind any chunk still being parsed, so rows and the final result arrive in order.
+        QtConcurrent::run(&decodePool, [stream, statusCode, contentType, body, error]() {
+            Perf::Scope scope("api.parse.final");
+            FetchOutcome outcome;
+            if (!error.isEmpty()) {
+                outcome.result = buildErrorResult(QString::fromUtf8("❌ 連線失敗：%1").arg(error));
+                return outcome;
+            }
+
+            if (statusCode != 200) {
+                outcome.result = buildErrorResult(QString::fromUtf8("❌ HTTP %1\n%2")
+                                                      .arg(statusCode)
+                                                      .arg(QString::fromUtf8(body.left(200))));
+                return outcome;
+            }
+
+            if (!contentType.contains("application/json")) {
+                outcome.result = buildErrorResult(QString::fromUtf8("❌ 回應非JSON（可能權限/網址錯）\n%1")
+                                                      .arg(QString::fromUtf8(body.left(200))));
+                return outcome;
+            }
+
+            stream->parser.feed(body, &outcome.tail);
+
+            QJsonObject envelope;
+            if (!stream->parser.finish(&envelope)) {
+                outcome.result = buildErrorResult(QString::fromUtf8("❌ 回應格式錯誤"));
+                return outcome;
+            }
+
+            outcome.result = resultFromEnvelope(envelope, true, QString::fromUtf8("查詢"));
+            return outcome;
+        }).then(this, [this, pending, cacheKey, fetchMs](const FetchOutcome &outcome) {
+            Perf::Scope scope("api.deliver");
+            const QList<PendingFetch::Subscriber> subscribers = pending->subscribers;
+            pending->subscribers.clear();
+            for (const auto &subscriber : subscribers) {
+                ticketFetchKeys.remove(subscriber.ticket);
+            }
+
+            for (const auto &row : outcome.tail) {
+                pending->rows.append(row);
+            }
+            if (!outcome.tail.isEmpty()) {
+                for (const auto &subscriber : subscribers) {
+                    if (subscriber.onRows) {
+                        subscriber.onRows(outcome.tail);
+                    }
+                }
+            }
+
+            Result result = outcome.result;
+            if (result.ok) {
+                result.rows = pending->rows;
+                result.fetchedAt = QDateTime::currentDateTime();
+                if (!cacheKey.isEmpty()) {
+                    ++fetchCount;
+                    fetchMsTotal += fetchMs;
+                    const QJsonArray rows = pending->rows;
+                    QtConcurrent::run(&decodePool, [cacheKey, rows]() {
+                        return RecordCache::encode(cacheKey, rows);
+                    }).then(this, [this, cacheKey](const QByteArray &bytes) {
+                        cache.storeEncoded(cacheKey, bytes);
+                    });
+                }
+            }
+            pending->rows = QJsonArray();
+            for (const auto &subscriber : subscribers) {
+                subscriber.handler(result);
+            }
+        });
+    });
+}
+
+void ApiClient::postRecordAsync(const QJsonObject &data, ResultHandler handler) {
+    postSingleAsync(data, false, handler);
+}
+
+void ApiClient::postSingleAsync(const QJsonObject &data, bool requireJson, ResultHandler handler) {
+    QJsonObject payload;
+    payload.insert("type", "customer_service");
+    payload.insert("timestamp", static_cast<qint64>(QDateTime::currentSecsSinceEpoch()));
+    payload.insert("data", data);
+
+    sendPostAsync(payload, requireJson, [this, data, handler](const Result &result) {
+        if (result.ok) {
+            rememberPostedRecord(data);
+        }
+        handler(result);
+    });
+}
+
+void ApiClient::postRecordsAsync(const QList<QJsonObject> &records, BatchHandler handler) {
+    auto state = std::make_shared<BatchState>();
+    state->records = records;
+    state->handler = handler;
+
+    for (int i = 0; i < records.size(); ++i) {
+        Result pending;
+        pending.message = QString::fromUtf8("❌ 未送出");
+        state->results.append(pending);
+    }
+
+    if (!batchPost) {
+        for (int i = 0; i < records.size(); ++i) {
+            state->chunks.append(qMakePair(i, i + 1));
+        }
+        postNextBatchChunk(state);
+        return;
+    }
+
+    int begin = 0;
+    int bytes = 0;
+    for (int i = 0; i < records.size(); ++i) {
+        state->encoded.append(QJsonDocument(records.at(i)).toJson(QJsonDocument::Compact));
+        const int size = state->encoded.last().size() + 1;
+        if (i > begin && (i - begin >= kMaxBatchRecords || bytes + size > kMaxBatchBytes)) {
+            state->chunks.append(qMakePair(begin, i));
+            begin = i;
+            bytes = 0;
+        }
+        bytes += size;
+    }
+    if (begin < records.size()) {
+        state->chunks.append(qMakePair(begin, int(records.size())));
+    }
+    postNextBatchChunk(state);
+}
+
+void ApiClient::postNextBatchChunk(const std::shared_ptr<BatchState> &state) {
+    if (state->chunks.isEmpty() || !state->error.isEmpty()) {
+        finishBatch(state);
+        return;
+    }
+
+    const QPair<int, int> chunk = state->chunks.takeFirst();
+    if (!batchPost) {
+        const int index = chunk.first;
+        // Batches feed the outbox, which deletes what is reported as sent, so only a JSON confirmation counts.
+        postSingleAsync(state->records.at(index), true, [this, state, index](const Result &result) {
+            state->results[index] = result;
+            // A refused record does not hold up the ones behind it; a failed request does.
+            if (!result.ok && !result.rejected) {
+                state->error = result.message;
+            }
+            postNextBatchChunk(state);
+        });
+        return;
+    }
+    sendBatchChunkAsync(state, chunk.first, chunk.second);
+}
+
+void ApiClient::sendBatchChunkAsync(const std::shared_ptr<BatchState> &state, int begin, int end) {
+    QByteArray body = "{\"type\":\"customer_service_batch\",\"timestamp\":";
+    body += QByteArray::number(QDateTime::currentSecsSinceEpoch());
+    body += ",\"records\":[";
+    for (int i = begin; i < end; ++i) {
+        if (i > begin) {
+            body += ',';
+        }
+        body += state->encoded.at(i);
+    }
+    body += "]}";
+
+    QNetworkReply *reply = postJson(body);
+    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, state, begin, end]() {
+        const int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        const QString contentType = reply->header(QNetworkRequest::ContentTypeHeader).toString().toLower();
+        const QByteArray body = readBody(reply);
+        const QString error = reply->error() == QNetworkReply::NoError ? QString() : reply->errorString();
+        reply->deleteLater();
+
+        if (statusCode == 413 && end - begin > 1) {
+            const int middle = begin + (end - begin) / 2;
+            state->chunks.prepend(qMakePair(middle, end));
+            state->chunks.prepend(qMakePair(begin, middle));
+            postNextBatchChunk(state);
             return;
         }
 
-        if (statusCode != 200) {
-            handler(buildErrorResult(QString::fromUtf8("❌ HTTP %1\n%2")
-                                         .arg(statusCode)
-                                         .arg(QString::fromUtf8(body.left(200)))));
+        if (!error.isEmpty() || statusCode != 200) {
+            state->error = error.isEmpty() ? QString::fromUtf8("❌ HTTP %1\n%2").arg(statusCode).arg(QString::fromUtf8(body.left(200)))
+                                           : QString::fromUtf8("❌ 連線失敗：%1").arg(error);
+            postNextBatchChunk(state);
             return;
         }
 
         if (!contentType.contains("application/json")) {
-            handler(buildErrorResult(QString::fromUtf8("❌ 回應非JSON（可能權限/網址錯）\n%1")
-                                         .arg(QString::fromUtf8(body.left(200)))));
+            state->error = QString::fromUtf8("❌ 回應非JSON（可能權限/網址錯）\n%1").arg(QString::fromUtf8(body.left(200)));
+            postNextBatchChunk(state);
+            return;
+        }
+        const QJsonDocument doc = QJsonDocument::fromJson(body);
+        const QJsonObject obj = doc.object();
+        const QJsonArray results = obj.value("results").toArray();
+        const bool rejected = obj.value("ok").isBool() && !obj.value("ok").toBool();
+        if (!doc.isObject() || (!rejected && results.size() != end - begin)) {
+            state->error = QString::fromUtf8("❌ 批次回應格式錯誤（%1 筆結果，送出 %2 筆）").arg(results.size()).arg(end - begin);
+            postNextBatchChunk(state);
             return;
         }
 
-        handler(parseJsonResult(body, true, QString::fromUtf8("查詢")));
+        for (int i = begin; i < end; ++i) {
+            Result result;
+            const QJsonObject item = results.at(i - begin).toObject();
+            if (rejected) {
+                result.message = QString::fromUtf8("❌ 新增失敗：%1").arg(obj.value("error").toString("未知錯誤"));
+                result.rejected = true;
+            } else if (item.value("ok").isBool() && !item.value("ok").toBool()) {
+                result.message = QString::fromUtf8("❌ 新增失敗：%1").arg(item.value("error").toString("未知錯誤"));
+                result.rejected = true;
+            } else if (item.value("ok").toBool()) {
+                result.ok = true;
+                result.message = QString::fromUtf8("✅ 新增成功");
+                rememberPostedRecord(state->records.at(i));
+            } else {
+                result.message = QString::fromUtf8("❌ 回應未確認第 %1 筆").arg(i - begin + 1);
+                state->error = result.message;
+            }
+            state->results[i] = result;
+        }
+        postNextBatchChunk(state);
     });
 }
 
-void ApiClient::postRecordAsync(const QJsonObject &data, ResultHandler handler) {
-    QJsonObject payload;
-    payload.insert("type", "customer_service");
-    payload.insert("timestamp", static_cast<qint64>(QDateTime::currentSecsSinceEpoch()));
-    payload.insert("data", data);
-    sendPostAsync(payload, handler);
+void ApiClient::finishBatch(const std::shared_ptr<BatchState> &state) {
+    int succeeded = 0;
+    for (const auto &result : state->results) {
+        if (result.ok) {
+            ++succeeded;
+        }
+    }
+
+    BatchResult batch;
+    batch.ok = state->error.isEmpty();
+    batch.records = state->results;
+    if (!batch.ok) {
+        batch.message = state->error;
+    } else if (succeeded == state->results.size()) {
+        batch.message = QString::fromUtf8("✅ 新增成功 %1 筆").arg(succeeded);
+    } else {
+        batch.message = QString::fromUtf8("⚠️ 新增成功 %1 筆，失敗 %2 筆").arg(succeeded).arg(state->results.size() - succeeded);
+    }
+    state->handler(batch);
+}
+
+void ApiClient::rememberPostedRecord(const QJsonObject &data) {
+    const QString phone = data.value("phone").toString().trimmed();
+    if (phone.isEmpty()) {
+        return;
+    }
+    cache.appendRow(phone, data);
 }
 
-void ApiClient::getRecordsAsync(const QString &phone, bool onlyWater, ResultHandler handler) {
+ApiClient::Ticket ApiClient::getRecordsAsync(const QString &phone, bool onlyWater, ResultHandler handler, RowsHandler onRows) {
+    // The water filter is applied by the caller, so both kinds of query share one download per customer.
+    Q_UNUSED(onlyWater);
+    return requestRecords(phone, kRefreshWindowSecs, true, handler, onRows);
+}
+
+ApiClient::Ticket ApiClient::fetchRawAsync(const QString &phone, ResultHandler handler) {
+    return requestRecords(phone, kRefreshWindowSecs, true, handler, RowsHandler());
+}
+
+ApiClient::Ticket ApiClient::fetchRecentAsync(const QString &phone, qint64 maxAgeSecs, ResultHandler handler) {
+    return requestRecords(phone, maxAgeSecs, false, handler, RowsHandler());
+}
+
+ApiClient::Ticket ApiClient::fetchSyncPageAsync(const QString &after, int limit, ResultHandler handler) {
     QUrl url(endpointUrl());
     QUrlQuery query;
-    query.addQueryItem("phone", phone);
-    if (onlyWater) {
-        query.addQueryItem("only_water", "1");
-    }
+    query.addQueryItem("sync", "1");
+    query.addQueryItem("after", after);
+    query.addQueryItem("limit", QString::number(limit));
     url.setQuery(query);
-    sendGetAsync(url, handler);
+
+    const Ticket ticket = ++nextTicket;
+    sendGetAsync(url, QString(), ticket, handler, RowsHandler());
+    return ticket;
+}
+
+void ApiClient::cancel(Ticket ticket) {
+    if (cachedTickets.remove(ticket)) {
+        return;
+    }
+    const QString fetchKey = ticketFetchKeys.take(ticket);
+    const auto pending = pendingFetches.value(fetchKey);
+    if (!pending) {
+        return;
+    }
+    pending->subscribers.removeIf([ticket](const PendingFetch::Subscriber &subscriber) {
+        return subscriber.ticket == ticket;
+    });
+    if (pending->subscribers.isEmpty()) {
+        pendingFetches.remove(fetchKey);
+        ++netStats.cancelled;
+        pending->reply->abort();
+    }
 }
 
-void ApiClient::fetchRawAsync(const QString &phone, ResultHandler handler) {
+ApiClient::Ticket ApiClient::requestRecords(const QString &phone, qint64 freshSecs, bool offerStale, ResultHandler handler,
+                                            RowsHandler onRows) {
+    const Ticket ticket = ++nextTicket;
     QUrl url(endpointUrl());
     QUrlQuery query;
     query.addQueryItem("phone", phone);
     url.setQuery(query);
-    sendGetAsync(url, handler);
+
+    QString path;
+    QDateTime fetchedAt;
+    const bool cached = cache.locate(phone, &path, &fetchedAt);
+    const bool fresh = cached && fetchedAt.secsTo(QDateTime::currentDateTime()) < freshSecs;
+    if (!fresh && !(cached && offerStale)) {
+        sendGetAsync(url, phone, ticket, handler, onRows);
+        return ticket;
+    }
+
+    // The cached copy is read on the decode pool and delivered from the event loop like any other answer; the refresh
+    // starts only after it, so the stale copy can never overwrite the downloaded one.
+    cachedTickets.insert(ticket);
+    QtConcurrent::run(&decodePool, [path]() {
+        Perf::Scope scope("api.cache.read");
+        Result result;
+        result.ok = RecordCache::readRows(path, &result.rows);
+        return result;
+    }).then(this, [this, ticket, url, phone, handler, onRows, fetchedAt, freshSecs, fresh](Result result) {
+        if (!cachedTickets.contains(ticket)) {
+            return;
+        }
+        if (!result.ok) {
+            cachedTickets.remove(ticket);
+            cache.remove(phone);
+            sendGetAsync(url, phone, ticket, handler, onRows);
+            return;
+        }
+        result.fetchedAt = fetchedAt;
+        result.fromCache = !fresh;
+        if (fresh) {
+            result.message = QString::fromUtf8("⚡ 本機快取（%1），%2 秒內不重複下載")
+                                 .arg(fetchedAt.toString("HH:mm:ss"))
+                                 .arg(freshSecs);
+        } else {
+            result.message = QString::fromUtf8("⚡ 本機快取（%1），背景更新中...").arg(fetchedAt.toString("MM-dd HH:mm"));
+        }
+        handler(result);
+        if (cachedTickets.remove(ticket) && !fresh) {
+            sendGetAsync(url, phone, ticket, handler, onRows);
+        }
+    });
+    return ticket;
+}
+
+StorageBackend::CustomerSource ApiClient::cachedCustomers() const {
+    const QList<QPair<QString, QString>> files = cache.files();
+    return [files](const CustomerVisitor &visit) {
+        for (const auto &file : files) {
+            QJsonArray rows;
+            // A file evicted since the snapshot was taken is simply skipped.
+            if (RecordCache::readRows(file.second, &rows)) {
+                visit(file.first, rows);
+            }
+        }
+    };
+}
+
+RecordCache::Stats ApiClient::cacheStats() const {
+    return cache.stats();
+}
+
+qint64 ApiClient::averageFetchMs() const {
+    return fetchCount > 0 ? fetchMsTotal / fetchCount : 0;
 }
 
-ApiClient::Result ApiClient::buildErrorResult(const QString &message) const {
+ApiClient::NetworkStats ApiClient::networkStats() const {
+    NetworkStats stats = netStats;
+    stats.avgHandshakeMs = stats.newConnections > 0 ? handshakeMsTotal / stats.newConnections : 0;
+    stats.avgFirstByteMs = stats.requests > 0 ? firstByteMsTotal / stats.requests : 0;
+    return stats;
+}
+
+ApiClient::Result ApiClient::buildErrorResult(const QString &message) {
     Result result;
     result.ok = false;
     result.message = message;
     return result;
 }
 
-ApiClient::Result ApiClient::parseJsonResult(const QByteArray &body, bool expectRows, const QString &errorPrefix) const {
+ApiClient::Result ApiClient::parseJsonResult(const QByteArray &body, bool expectRows, const QString &errorPrefix) {
+    Perf::Scope scope("api.parse.json");
     QJsonDocument doc = QJsonDocument::fromJson(body);
     if (!doc.isObject()) {
         return buildErrorResult(QString::fromUtf8("❌ 回應格式錯誤"));
     }
+    return resultFromEnvelope(doc.object(), expectRows, errorPrefix);
+}
 
-    QJsonObject obj = doc.object();
+ApiClient::Result ApiClient::resultFromEnvelope(const QJsonObject &obj, bool expectRows, const QString &errorPrefix) {
     if (obj.value("ok").isBool() && !obj.value("ok").toBool()) {
-        return buildErrorResult(QString::fromUtf8("❌ %1失敗：%2").arg(errorPrefix, obj.value("error").toString("未知錯誤")));
+        Result result = buildErrorResult(QString::fromUtf8("❌ %1失敗：%2").arg(errorPrefix, obj.value("error").toString("未知錯誤")));
+        result.rejected = true;
+        return result;
     }
 
     Result result;
     result.ok = true;
     if (expectRows) {
         result.rows = obj.value("rows").toArray();
+        result.hasMore = obj.value("has_more").toBool();
+        result.cursor = obj.value("next").toVariant().toString();
     } else {
         result.message = QString::fromUtf8("✅ 新增成功");
     }
@@ -1,37 +1,110 @@
 #pragma once
 
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
 #include <QJsonArray>
 #include <QJsonObject>
+#include <QList>
 #include <QNetworkAccessManager>
-#include <QObject>
+#include <QNetworkRequest>
+#include <QSet>
 #include <QString>
+#include <QThreadPool>
 
 #include <functional>
+#include <memory>
 
-class ApiClient : public QObject {
+#include "RecordCache.h"
+#include "StorageBackend.h"
+
+class QNetworkReply;
+
+class ApiClient : public StorageBackend {
     Q_OBJECT
 
 public:
     explicit ApiClient(QObject *parent = nullptr);
 
-    struct Result {
-        bool ok = false;
-        QString message;
-        QJsonArray rows;
+    struct NetworkStats {
+        qint64 requests = 0;
+        qint64 newConnections = 0;
+        qint64 http2Requests = 0;
+        qint64 redirects = 0;
+        qint64 cancelled = 0;
+        qint64 bytesSent = 0;
+        qint64 wireBytesSent = 0;
+        qint64 bytesReceived = 0;
+        qint64 wireBytesReceived = 0;
+        qint64 dnsMs = -1;
+        qint64 avgHandshakeMs = 0;
+        qint64 avgFirstByteMs = 0;
     };
 
-    using ResultHandler = std::function<void(const Result &)>;
+    void postRecordAsync(const QJsonObject &data, ResultHandler handler) override;
+    void postRecordsAsync(const QList<QJsonObject> &records, BatchHandler handler) override;
+    Ticket getRecordsAsync(const QString &phone, bool onlyWater, ResultHandler handler, RowsHandler onRows = RowsHandler()) override;
+    Ticket fetchRawAsync(const QString &phone, ResultHandler handler) override;
+    Ticket fetchRecentAsync(const QString &phone, qint64 maxAgeSecs, ResultHandler handler) override;
+    Ticket fetchSyncPageAsync(const QString &after, int limit, ResultHandler handler) override;
+    void cancel(Ticket ticket) override;
+
+    CustomerSource cachedCustomers() const override;
+    RecordCache::Stats cacheStats() const;
+    qint64 averageFetchMs() const;
+    NetworkStats networkStats() const;
 
-    void postRecordAsync(const QJsonObject &data, ResultHandler handler);
-    void getRecordsAsync(const QString &phone, bool onlyWater, ResultHandler handler);
-    void fetchRawAsync(const QString &phone, ResultHandler handler);
+    void warmUp();
+
+    void setEndpointUrl(const QString &url);
+    void setBatchPostEnabled(bool enabled);
+    bool batchPostEnabled() const;
+    void setRequestCompressionEnabled(bool enabled);
+    bool requestCompressionEnabled() const;
+
+    static Result parseJsonResult(const QByteArray &body, bool expectRows, const QString &errorPrefix);
 
 private:
+    struct BatchState;
+    struct FetchOutcome;
+    struct PendingFetch;
+
     QString endpointUrl();
-    void sendPostAsync(const QJsonObject &payload, ResultHandler handler);
-    void sendGetAsync(const QUrl &url, ResultHandler handler);
-    Result buildErrorResult(const QString &message) const;
-    Result parseJsonResult(const QByteArray &body, bool expectRows, const QString &errorPrefix) const;
+    QNetworkRequest makeRequest(const QUrl &url) const;
+    void trackReply(QNetworkReply *reply);
+    QNetworkReply *postJson(const QByteArray &body);
+    QByteArray readBody(QNetworkReply *reply);
+    void preconnect(const QUrl &url);
+    void sendPostAsync(const QJsonObject &payload, bool requireJson, ResultHandler handler);
+    void postSingleAsync(const QJsonObject &data, bool requireJson, ResultHandler handler);
+    void postNextBatchChunk(const std::shared_ptr<BatchState> &state);
+    void sendBatchChunkAsync(const std::shared_ptr<BatchState> &state, int begin, int end);
+    void finishBatch(const std::shared_ptr<BatchState> &state);
+    void rememberPostedRecord(const QJsonObject &data);
+    // Answers from a cached copy younger than freshSecs, or downloads; offerStale also hands out an older copy first.
+    Ticket requestRecords(const QString &phone, qint64 freshSecs, bool offerStale, ResultHandler handler, RowsHandler onRows);
+    void sendGetAsync(const QUrl &url, const QString &cacheKey, Ticket ticket, ResultHandler handler, RowsHandler onRows);
+    static Result buildErrorResult(const QString &message);
+    static Result resultFromEnvelope(const QJsonObject &obj, bool expectRows, const QString &errorPrefix);
 
     QNetworkAccessManager manager;
+    QString endpoint;
+    QString redirectedEndpoint;
+    QSet<QString> redirectOrigins;
+    QElapsedTimer lastActivity;
+    bool batchPost = false;
+    bool gzipRequests = false;
+    RecordCache cache;
+    QHash<QString, std::shared_ptr<PendingFetch>> pendingFetches;
+    QHash<Ticket, QString> ticketFetchKeys;
+    // Lookups answered from the cache whose handler has not run yet.
+    QSet<Ticket> cachedTickets;
+    Ticket nextTicket = 0;
+    qint64 fetchCount = 0;
+    qint64 fetchMsTotal = 0;
+    NetworkStats netStats;
+    qint64 handshakeMsTotal = 0;
+    qint64 firstByteMsTotal = 0;
+    // One thread, so chunks of a response are parsed in arrival order; declared last so it drains first.
+    QThreadPool decodePool;
 };
@@ -0,0 +1,442 @@
+#include "BulkImporter.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include "Compression.h"
+#include "DateUtils.h"
+#include "RecordInput.h"
+#include "Records.h"
+
+namespace {
+const int kChunkRows = 2000;
+const int kFeedRows = 200;
+const int kFeedIntervalMs = 1000;
+const int kMaxOutboxDepth = 400;
+
+struct Span {
+    qsizetype start = 0;
+    qsizetype length = 0;
+    int line = 0;
+};
+
+struct Chunk {
+    int begin = 0;
+    int end = 0;
+};
+
+struct ChunkResult {
+    QList<QJsonObject> records;
+    QList<BulkImporter::Issue> issues;
+};
+
+const QHash<QString, QString> &fieldAliases() {
+    static const QHash<QString, QString> aliases = [] {
+        const QList<QStringList> groups = {
+            {"service_date", "service_date_ad", "service_date_roc", "date", "日期", "日期(民國)", "服務日期"},
+            {"customer_name", "name", "姓名"},
+            {"phone", "電話"},
+            {"address", "地址"},
+            {"purposes", "用途", "用途(安裝/購買)"},
+            {"items", "項目"},
+            {"other_item_text", "其他", "其他項目"},
+            {"water_replace_cycle", "更換週期"},
+            {"next_replace_date_roc", "下次更換日期"},
+            {"warranty_end_date_roc", "保固期限"},
+            {"notes", "備註"},
+            {"created_at", "建立時間"}
+        };
+        QHash<QString, QString> map;
+        for (const auto &group : groups) {
+            for (const auto &alias : group) {
+                map.insert(alias.toCaseFolded(), group.first());
+            }
+        }
+        return map;
+    }();
+    return aliases;
+}
+
+QString canonicalKey(const QString &name) {
+    return fieldAliases().value(name.trimmed().toCaseFolded());
+}
+
+QStringList listValue(const QJsonValue &value) {
+    if (value.isArray() || value.toString().trimmed().startsWith(QLatin1Char('['))) {
+        return Records::toStringList(value);
+    }
+    const QString separators = QStringLiteral("/、,，;；|");
+    QStringList values;
+    QString item;
+    for (const QChar c : value.toString()) {
+        if (!separators.contains(c)) {
+            item += c;
+            continue;
+        }
+        if (!item.trimmed().isEmpty()) {
+            values.append(item.trimmed());
+        }
+        item.clear();
+    }
+    if (!item.trimmed().isEmpty()) {
+        values.append(item.trimmed());
+    }
+    return values;
+}
+
+QString isoDate(const QString &text) {
+    if (DateUtils::isYmd(text)) {
+        return text;
+    }
+    const QDate date = DateUtils::rocToAdDate(text);
+    return date.isValid() ? DateUtils::dateToIso(date) : text;
+}
+
+QString rocDate(const QString &text) {
+    const QString trimmed = text.trimmed();
+    if (DateUtils::isYmd(trimmed)) {
+        const QDate date = DateUtils::parseYmd(trimmed);
+        return date.isValid() ? DateUtils::dateToRoc(date) : trimmed;
+    }
+    const QString normalized = DateUtils::normalizeRocStr(trimmed);
+    return normalized.isEmpty() ? trimmed : normalized;
+}
+
+QJsonObject validate(const QJsonObject &row, const QString &importedAt, QString *error) {
+    RecordInput::Fields fields;
+    fields.serviceDate = isoDate(row.value("service_date").toString().trimmed());
+    fields.customerName = row.value("customer_name").toString();
+    fields.phone = row.value("phone").toString();
+    fields.address = row.value("address").toString();
+    fields.purposes = listValue(row.value("purposes"));
+    fields.items = listValue(row.value("items"));
+    fields.otherItemText = row.value("other_item_text").toString();
+    fields.waterCycle = row.value("water_replace_cycle").toString().trimmed();
+    fields.notes = row.value("notes").toString();
+
+    for (const auto &purpose : std::as_const(fields.purposes)) {
+        if (!Records::kPurposes.contains(purpose)) {
+            *error = QString("❌ 未知用途：%1").arg(purpose);
+            return {};
+        }
+    }
+    for (const auto &item : std::as_const(fields.items)) {
+        if (!Records::kItems.contains(item)) {
+            *error = QString("❌ 未知項目：%1").arg(item);
+            return {};
+        }
+    }
+
+    // Blank follow-up dates are filled in the same way the add-record form fills them.
+    const QDate date = DateUtils::parseYmd(fields.serviceDate);
+    const QString nextReplace = rocDate(row.value("next_replace_date_roc").toString());
+    const QString warrantyEnd = rocDate(row.value("warranty_end_date_roc").toString());
+    fields.nextReplaceRoc = nextReplace.isEmpty() ? RecordInput::nextReplaceRoc(date, fields.items, fields.waterCycle)
+                                                  : nextReplace;
+    fields.warrantyEndRoc = warrantyEnd.isEmpty() ? RecordInput::warrantyEndRoc(date, fields.items) : warrantyEnd;
+
+    const QString createdAt = row.value("created_at").toString().trimmed();
+    fields.createdAt = QDateTime::fromString(createdAt, "yyyy-MM-dd HH:mm:ss").isValid() ? createdAt : importedAt;
+    return RecordInput::build(fields, error);
+}
+
+QJsonObject canonicalObject(const QJsonObject &object) {
+    QJsonObject row;
+    for (auto it = object.constBegin(); it != object.constEnd(); ++it) {
+        const QString key = canonicalKey(it.key());
+        if (!key.isEmpty() && !row.contains(key)) {
+            row.insert(key, it.value());
+        }
+    }
+    return row;
+}
+
+QStringList csvFields(QStringView record) {
+    QStringList fields;
+    QString field;
+    bool quoted = false;
+    for (qsizetype i = 0; i < record.size(); ++i) {
+        const QChar c = record.at(i);
+        if (quoted) {
+            if (c == QLatin1Char('"') && i + 1 < record.size() && record.at(i + 1) == QLatin1Char('"')) {
+                field += c;
+                ++i;
+            } else if (c == QLatin1Char('"')) {
+                quoted = false;
+            } else {
+                field += c;
+            }
+        } else if (c == QLatin1Char('"')) {
+            quoted = true;
+        } else if (c == QLatin1Char(',')) {
+            fields.append(field);
+            field.clear();
+        } else if (c != QLatin1Char('\r')) {
+            field += c;
+        }
+    }
+    fields.append(field);
+    return fields;
+}
+
+// Splits on newlines outside quotes, so quoted fields may span lines.
+QList<Span> recordSpans(const QString &text, bool csv) {
+    QList<Span> spans;
+    bool quoted = false;
+    int line = 1;
+    Span span{0, 0, 1};
+    for (qsizetype i = 0; i < text.size(); ++i) {
+        const QChar c = text.at(i);
+        if (csv && c == QLatin1Char('"')) {
+            quoted = !quoted;
+        } else if (c == QLatin1Char('\n')) {
+            ++line;
+            if (!quoted) {
+                span.length = i - span.start;
+                if (!QStringView(text).mid(span.start, span.length).trimmed().isEmpty()) {
+                    spans.append(span);
+                }
+                span = Span{i + 1, 0, line};
+            }
+        }
+    }
+    span.length = text.size() - span.start;
+    if (!QStringView(text).mid(span.start, span.length).trimmed().isEmpty()) {
+        spans.append(span);
+    }
+    return spans;
+}
+
+QList<Chunk> chunksFor(int count) {
+    QList<Chunk> chunks;
+    for (int begin = 0; begin < count; begin += kChunkRows) {
+        chunks.append({begin, qMin(count, begin + kChunkRows)});
+    }
+    return chunks;
+}
+
+void merge(BulkImporter::Parsed &parsed, const QList<ChunkResult> &results) {
+    for (const auto &result : results) {
+        parsed.records += result.records;
+        parsed.issues += result.issues;
+    }
+}
+} // namespace
+
+BulkImporter::BulkImporter(OutboxQueue *outbox, const QString &directory, QObject *parent)
+    : QObject(parent), outbox(outbox) {
+    QString dir = directory;
+    if (dir.isEmpty()) {
+        dir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/import";
+    }
+    QDir().mkpath(dir);
+    statePath = dir + "/state.json";
+
+    feedTimer.setInterval(kFeedIntervalMs);
+    connect(&feedTimer, &QTimer::timeout, this, &BulkImporter::feed);
+    connect(&watcher, &QFutureWatcher<Parsed>::finished, this, &BulkImporter::handleLoaded);
+}
+
+bool BulkImporter::load(const QString &path) {
+    if (watcher.isRunning() || uploading) {
+        return false;
+    }
+    const QString importedAt = QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss");
+    watcher.setFuture(QtConcurrent::run([path, importedAt]() {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            Parsed failed;
+            failed.issues.append({0, QString("❌ 無法讀取檔案：%1").arg(file.errorString())});
+            return failed;
+        }
+        return parse(file.readAll(), formatForPath(path), importedAt);
+    }));
+    return true;
+}
+
+void BulkImporter::startUpload() {
+    if (uploading || watcher.isRunning() || cursor >= current.records.size()) {
+        return;
+    }
+    uploading = true;
+    saveState();
+    feed();
+    feedTimer.start();
+}
+
+void BulkImporter::pause() {
+    uploading = false;
+    feedTimer.stop();
+}
+
+bool BulkImporter::isLoading() const {
+    return watcher.isRunning();
+}
+
+bool BulkImporter::isUploading() const {
+    return uploading;
+}
+
+const BulkImporter::Parsed &BulkImporter::parsed() const {
+    return current;
+}
+
+int BulkImporter::queued() const {
+    return cursor;
+}
+
+BulkImporter::Format BulkImporter::formatForPath(const QString &path) {
+    if (path.endsWith(QStringLiteral(".jsonl"), Qt::CaseInsensitive)) {
+        return JsonLines;
+    }
+    return path.endsWith(QStringLiteral(".json"), Qt::CaseInsensitive) ? Json : Csv;
+}
+
+BulkImporter::Parsed BulkImporter::parse(const QByteArray &content, Format format, const QString &importedAt) {
+    QElapsedTimer timer;
+    timer.start();
+    Parsed parsed;
+    parsed.bytes = content.size();
+    parsed.fingerprint = Compression::crc32(content);
+
+    const auto check = [&importedAt](const QJsonObject &row, int line, ChunkResult &result) {
+        QString error;
+        const QJsonObject data = validate(row, importedAt, &error);
+        if (data.isEmpty()) {
+            result.issues.append({line, error});
+        } else {
+            result.records.append(data);
+        }
+    };
+
+    if (format == Json) {
+        QJsonParseError error;
+        const QJsonDocument doc = QJsonDocument::fromJson(content, &error);
+        const QJsonArray rows = doc.isArray() ? doc.array() : doc.object().value("rows").toArray();
+        if (error.error != QJsonParseError::NoError) {
+            parsed.issues.append({0, QString("❌ JSON 格式錯誤：%1").arg(error.errorString())});
+        }
+        parsed.rows = rows.size();
+        merge(parsed, QtConcurrent::blockingMapped<QList<ChunkResult>>(chunksFor(rows.size()), [&](const Chunk &chunk) {
+            ChunkResult result;
+            for (int i = chunk.begin; i < chunk.end; ++i) {
+                check(canonicalObject(rows.at(i).toObject()), i + 1, result);
+            }
+            return result;
+        }));
+        parsed.elapsedMs = timer.elapsed();
+        return parsed;
+    }
+
+    QString text = QString::fromUtf8(content);
+    if (text.startsWith(QChar(0xfeff))) {
+        text.remove(0, 1);
+    }
+    QList<Span> spans = recordSpans(text, format == Csv);
+
+    QStringList header;
+    if (format == Csv && !spans.isEmpty()) {
+        for (const auto &name : csvFields(QStringView(text).mid(spans.first().start, spans.first().length))) {
+            header.append(canonicalKey(name));
+        }
+        spans.removeFirst();
+    }
+    parsed.rows = spans.size();
+
+    merge(parsed, QtConcurrent::blockingMapped<QList<ChunkResult>>(chunksFor(spans.size()), [&](const Chunk &chunk) {
+        ChunkResult result;
+        for (int i = chunk.begin; i < chunk.end; ++i) {
+            const Span &span = spans.at(i);
+            const QStringView record = QStringView(text).mid(span.start, span.length);
+            if (format == JsonLines) {
+                QJsonParseError error;
+                const QJsonDocument doc = QJsonDocument::fromJson(record.toUtf8(), &error);
+                if (!doc.isObject()) {
+                    result.issues.append({span.line, QString("❌ JSON 格式錯誤：%1").arg(error.errorString())});
+                    continue;
+                }
+                check(canonicalObject(doc.object()), span.line, result);
+                continue;
+            }
+
+            const QStringList values = csvFields(record);
+            QJsonObject row;
+            for (int column = 0; column < header.size() && column < values.size(); ++column) {
+                if (!header.at(column).isEmpty() && !row.contains(header.at(column))) {
+                    row.insert(header.at(column), values.at(column));
+                }
+            }
+            check(row, span.line, result);
+        }
+        return result;
+    }));
+    parsed.elapsedMs = timer.elapsed();
+    return parsed;
+}
+
+void BulkImporter::handleLoaded() {
+    current = watcher.result();
+    cursor = 0;
+
+    // Resume where an earlier upload of the same file stopped.
+    QFile file(statePath);
+    if (file.open(QIODevice::ReadOnly)) {
+        const QJsonObject state = QJsonDocument::fromJson(file.readAll()).object();
+        if (quint32(state.value("fingerprint").toInteger()) == current.fingerprint
+            && state.value("bytes").toInteger() == current.bytes) {
+            cursor = qBound(0, int(state.value("cursor").toInteger()), int(current.records.size()));
+        }
+    }
+    emit loaded();
+    emit progress(cursor, int(current.records.size()));
+}
+
+void BulkImporter::feed() {
+    if (!uploading) {
+        return;
+    }
+    if (cursor >= current.records.size()) {
+        pause();
+        QFile::remove(statePath);
+        emit finished();
+        return;
+    }
+    if (outbox->depth() >= kMaxOutboxDepth) {
+        return;
+    }
+
+    const QList<QJsonObject> batch = current.records.mid(cursor, kFeedRows);
+    for (const auto &record : batch) {
+        outbox->enqueue(record);
+    }
+    // The outbox journal is on disk before the cursor moves, so a crash can repeat at most one batch but never drop one.
+    outbox->flush();
+    cursor += batch.size();
+    saveState();
+    emit recordsQueued(batch);
+    emit progress(cursor, int(current.records.size()));
+}
+
+bool BulkImporter::saveState() {
+    QJsonObject state;
+    state.insert("fingerprint", qint64(current.fingerprint));
+    state.insert("bytes", current.bytes);
+    state.insert("cursor", cursor);
+    state.insert("total", qint64(current.records.size()));
+
+    QSaveFile file(statePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(QJsonDocument(state).toJson(QJsonDocument::Compact));
+    return file.commit();
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <QByteArray>
+#include <QFutureWatcher>
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+#include "OutboxQueue.h"
+
+class BulkImporter : public QObject {
+    Q_OBJECT
+
+public:
+    enum Format { Csv, Json, JsonLines };
+
+    struct Issue {
+        int line = 0;
+        QString message;
+    };
+
+    struct Parsed {
+        QList<QJsonObject> records;
+        QList<Issue> issues;
+        int rows = 0;
+        qint64 bytes = 0;
+        quint32 fingerprint = 0;
+        qint64 elapsedMs = 0;
+    };
+
+    explicit BulkImporter(OutboxQueue *outbox, const QString &directory = QString(), QObject *parent = nullptr);
+
+    bool load(const QString &path);
+    void startUpload();
+    void pause();
+
+    bool isLoading() const;
+    bool isUploading() const;
+    const Parsed &parsed() const;
+    int queued() const;
+
+    static Format formatForPath(const QString &path);
+    static Parsed parse(const QByteArray &content, Format format, const QString &importedAt);
+
+signals:
+    void loaded();
+    void progress(int queued, int total);
+    void recordsQueued(const QList<QJsonObject> &records);
+    void finished();
+
+private:
+    void handleLoaded();
+    void feed();
+    bool saveState();
+
+    OutboxQueue *outbox = nullptr;
+    QString statePath;
+    QFutureWatcher<Parsed> watcher;
+    Parsed current;
+    int cursor = 0;
+    bool uploading = false;
+    QTimer feedTimer;
+};
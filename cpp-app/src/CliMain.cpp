@@ -0,0 +1,472 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDate>
+#include <QDateTime>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSet>
+#include <QTimer>
+
+#include <cstdio>
+#include <functional>
+#include <memory>
+
+#include "ApiClient.h"
+#include "BulkImporter.h"
+#include "DateUtils.h"
+#include "DueIndex.h"
+#include "LocalBackend.h"
+#include "RecordExporter.h"
+#include "RecordInput.h"
+#include "Records.h"
+
+namespace {
+const int kDefaultConcurrency = 4;
+const int kDefaultDueDays = 30;
+
+struct Input {
+    QString file;
+    int line = 0;
+    QString text;
+};
+
+struct Options {
+    int concurrency = kDefaultConcurrency;
+    bool onlyWater = false;
+    bool dryRun = false;
+    QString format;
+    QDate dueFrom;
+    int dueDays = kDefaultDueDays;
+    QString endpoint;
+    bool local = false;
+};
+
+using Done = std::function<void()>;
+using Task = std::function<void(const Done &done)>;
+
+bool readSource(const QString &path, QByteArray *content, QString *error) {
+    QFile file(path);
+    const bool opened = path == "-" ? file.open(stdin, QIODevice::ReadOnly) : file.open(QIODevice::ReadOnly);
+    if (!opened) {
+        *error = QString("cannot read %1: %2").arg(path, file.errorString());
+        return false;
+    }
+    *content = file.readAll();
+    return true;
+}
+
+QVector<Input> splitLines(const QString &file, const QByteArray &content) {
+    QVector<Input> inputs;
+    const QList<QByteArray> lines = content.split('\n');
+    for (int i = 0; i < lines.size(); ++i) {
+        const QString text = QString::fromUtf8(lines.at(i)).trimmed();
+        if (!text.isEmpty() && !text.startsWith('#')) {
+            inputs.append({file, i + 1, text});
+        }
+    }
+    return inputs;
+}
+
+// A line is either a JSON object or comma-separated fields; returns the fields under the given keys.
+QStringList lineFields(const QString &text, const QStringList &keys) {
+    QStringList fields;
+    if (text.startsWith('{')) {
+        const QJsonObject obj = QJsonDocument::fromJson(text.toUtf8()).object();
+        for (const auto &key : keys) {
+            fields.append(obj.value(key).toVariant().toString().trimmed());
+        }
+        return fields;
+    }
+    const QStringList parts = text.split(',');
+    for (int i = 0; i < keys.size(); ++i) {
+        fields.append(i < parts.size() ? parts.at(i).trimmed() : QString());
+    }
+    return fields;
+}
+
+bool looksLikePhone(const QString &text) {
+    for (const QChar c : text) {
+        if (c.isDigit()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QJsonObject origin(const Input &input) {
+    return QJsonObject{{"file", input.file}, {"line", input.line}};
+}
+
+QByteArray csvField(const QString &value) {
+    QString text = value;
+    if (text.contains(',') || text.contains('"') || text.contains('\n')) {
+        text = '"' + text.replace('"', "\"\"") + '"';
+    }
+    return text.toUtf8();
+}
+
+// Runs the tasks with at most `limit` in flight and returns once the last one has called done().
+void runTasks(const QVector<Task> &tasks, int limit) {
+    if (tasks.isEmpty()) {
+        return;
+    }
+    int next = 0;
+    int inFlight = 0;
+    std::function<void()> launch;
+    launch = [&]() {
+        while (inFlight < limit && next < tasks.size()) {
+            ++inFlight;
+            tasks.at(next++)([&]() {
+                --inFlight;
+                // Dry runs finish synchronously, so refilling is deferred to keep the stack flat.
+                QTimer::singleShot(0, QCoreApplication::instance(), [&launch]() { launch(); });
+            });
+        }
+        if (inFlight == 0 && next >= tasks.size()) {
+            QCoreApplication::quit();
+        }
+    };
+    QTimer::singleShot(0, QCoreApplication::instance(), [&launch]() { launch(); });
+    QCoreApplication::exec();
+}
+
+class Cli {
+public:
+    Cli(QFile &out, const Options &options) : out(out), options(options) {
+        if (!options.endpoint.isEmpty()) {
+            client.setEndpointUrl(options.endpoint);
+        }
+        if (options.local) {
+            local = std::make_unique<LocalBackend>();
+        }
+        backend = local ? static_cast<StorageBackend *>(local.get()) : &client;
+    }
+
+    int query(const QVector<Input> &inputs);
+    int due(const QVector<Input> &inputs);
+    int submit(const QList<QPair<QString, QByteArray>> &sources, const QString &inputFormat);
+    int replace(const QVector<Input> &inputs);
+
+private:
+    using RowsHandler = std::function<void(const QString &phone, const ApiClient::Result &result)>;
+
+    QVector<Task> fetchTasks(const QVector<Input> &inputs, const RowsHandler &handler);
+    void post(const QJsonObject &result, const QJsonObject &data, const Done &done);
+    void emitJson(const QJsonObject &obj);
+
+    QFile &out;
+    Options options;
+    ApiClient client;
+    std::unique_ptr<LocalBackend> local;
+    StorageBackend *backend = nullptr;
+    int failures = 0;
+};
+
+void Cli::emitJson(const QJsonObject &obj) {
+    const QByteArray line = QJsonDocument(obj).toJson(QJsonDocument::Compact) + '\n';
+    if (!obj.value("ok").toBool()) {
+        ++failures;
+        // Table formats keep their file clean; failures go to stderr instead.
+        if (options.format != "jsonl") {
+            std::fwrite(line.constData(), 1, line.size(), stderr);
+            return;
+        }
+    }
+    out.write(line);
+    out.flush();
+}
+
+QVector<Task> Cli::fetchTasks(const QVector<Input> &inputs, const RowsHandler &handler) {
+    QVector<Task> tasks;
+    QSet<QString> seen;
+    for (const auto &input : inputs) {
+        const QString phone = lineFields(input.text, {"phone"}).first();
+        if (!looksLikePhone(phone) || seen.contains(phone)) {
+            continue;
+        }
+        seen.insert(phone);
+        tasks.append([this, phone, handler](const Done &done) {
+            backend->fetchRawAsync(phone, [phone, handler, done](const ApiClient::Result &result) {
+                if (result.fromCache) {
+                    return; // A stale cached copy; the downloaded answer follows.
+                }
+                handler(phone, result);
+                done();
+            });
+        });
+    }
+    return tasks;
+}
+
+int Cli::query(const QVector<Input> &inputs) {
+    const bool table = options.format == "csv" || options.format == "xlsx";
+    QVector<Records::ServiceRecord> collected;
+    runTasks(fetchTasks(inputs, [this, table, &collected](const QString &phone, const ApiClient::Result &result) {
+        if (!result.ok) {
+            emitJson(QJsonObject{{"phone", phone}, {"ok", false}, {"error", result.message}});
+            return;
+        }
+        if (table) {
+            QVector<Records::ServiceRecord> records = Records::decodeRows(result.rows);
+            Records::sortNewestFirst(records);
+            Records::assignWaterRanks(records);
+            collected += records;
+            return;
+        }
+        QJsonArray rows;
+        for (const auto &row : result.rows) {
+            if (!options.onlyWater || Records::toStringList(row.toObject().value("items")).contains(Records::kWaterItem)) {
+                rows.append(row);
+            }
+        }
+        emitJson(QJsonObject{{"phone", phone}, {"ok", true}, {"count", int(rows.size())}, {"rows", rows}});
+    }), options.concurrency);
+
+    if (table) {
+        const auto source = [this, &collected](const RecordExporter::RowVisitor &visit) {
+            for (const auto &record : std::as_const(collected)) {
+                if (Records::matches(record, options.onlyWater) && !visit(record)) {
+                    return;
+                }
+            }
+        };
+        const RecordExporter::Format format = options.format == "xlsx" ? RecordExporter::Xlsx : RecordExporter::Csv;
+        if (!RecordExporter::exportRows(&out, format, options.onlyWater, source, RecordExporter::ProgressHandler(), nullptr)) {
+            std::fprintf(stderr, "cannot write the %s output\n", qPrintable(options.format));
+            return 2;
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+int Cli::due(const QVector<Input> &inputs) {
+    DueIndex index;
+    runTasks(fetchTasks(inputs, [this, &index](const QString &phone, const ApiClient::Result &result) {
+        if (!result.ok) {
+            emitJson(QJsonObject{{"phone", phone}, {"ok", false}, {"error", result.message}});
+            return;
+        }
+        index.replaceCustomer(phone, Records::decodeRows(result.rows));
+    }), options.concurrency);
+
+    const bool csv = options.format == "csv";
+    if (csv) {
+        out.write("\xEF\xBB\xBF");
+        out.write("到期日,類型,姓名,電話,地址,服務日期\r\n");
+    }
+    for (const auto &entry : index.dueBetween(options.dueFrom, options.dueFrom.addDays(options.dueDays))) {
+        const QString kind = entry.kind == DueIndex::FilterChange ? "filter_change" : "warranty_end";
+        if (csv) {
+            const QStringList cells = {entry.dueRoc, entry.kind == DueIndex::FilterChange ? "濾心更換" : "保固到期",
+                                       entry.customerName, entry.phone, entry.address, entry.serviceDateRoc};
+            QByteArrayList line;
+            for (const auto &cell : cells) {
+                line.append(csvField(cell));
+            }
+            out.write(line.join(',') + "\r\n");
+            continue;
+        }
+        emitJson(QJsonObject{{"ok", true},
+                             {"kind", kind},
+                             {"due_date", DateUtils::dateToIso(QDate::fromJulianDay(entry.dueDay))},
+                             {"due_date_roc", entry.dueRoc},
+                             {"service_date_roc", entry.serviceDateRoc},
+                             {"customer_name", entry.customerName},
+                             {"phone", entry.phone},
+                             {"address", entry.address}});
+    }
+    out.flush();
+    return failures == 0 ? 0 : 1;
+}
+
+void Cli::post(const QJsonObject &result, const QJsonObject &data, const Done &done) {
+    if (options.dryRun) {
+        QJsonObject line = result;
+        line.insert("ok", true);
+        line.insert("record", data);
+        emitJson(line);
+        done();
+        return;
+    }
+    backend->postRecordAsync(data, [this, result, done](const ApiClient::Result &posted) {
+        QJsonObject line = result;
+        line.insert("ok", posted.ok);
+        if (!posted.ok) {
+            line.insert("error", posted.message);
+        }
+        emitJson(line);
+        done();
+    });
+}
+
+int Cli::submit(const QList<QPair<QString, QByteArray>> &sources, const QString &inputFormat) {
+    const QString importedAt = QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss");
+    QVector<Task> tasks;
+    for (const auto &source : sources) {
+        BulkImporter::Format format = BulkImporter::formatForPath(source.first == "-" ? QString(".jsonl") : source.first);
+        if (inputFormat == "csv") {
+            format = BulkImporter::Csv;
+        } else if (inputFormat == "json") {
+            format = BulkImporter::Json;
+        } else if (inputFormat == "jsonl") {
+            format = BulkImporter::JsonLines;
+        }
+
+        const BulkImporter::Parsed parsed = BulkImporter::parse(source.second, format, importedAt);
+        for (const auto &issue : parsed.issues) {
+            emitJson(QJsonObject{{"file", source.first}, {"line", issue.line}, {"ok", false}, {"error", issue.message}});
+        }
+        for (const auto &record : parsed.records) {
+            const QJsonObject result{{"file", source.first},
+                                     {"phone", record.value("phone")},
+                                     {"created_at", record.value("created_at")}};
+            tasks.append([this, result, record](const Done &done) {
+                post(result, record, done);
+            });
+        }
+    }
+    runTasks(tasks, options.concurrency);
+    return failures == 0 ? 0 : 1;
+}
+
+int Cli::replace(const QVector<Input> &inputs) {
+    QVector<Task> tasks;
+    for (const auto &input : inputs) {
+        const QStringList fields = lineFields(input.text, {"phone", "replace_date", "cycle", "note"});
+        const QString phone = fields.at(0);
+        QJsonObject result = origin(input);
+        result.insert("phone", phone);
+        if (!looksLikePhone(phone)) {
+            continue;
+        }
+        QString error;
+        if (!DateUtils::isYmd(fields.at(1))) {
+            error = "❌ 更換日期格式錯誤，請用 YYYY-MM-DD";
+        } else if (Records::cycleToMonths(fields.at(2)) <= 0) {
+            error = "❌ 請選擇更換週期（半年/一年/一年半/兩年）";
+        }
+        if (!error.isEmpty()) {
+            result.insert("ok", false);
+            result.insert("error", error);
+            emitJson(result);
+            continue;
+        }
+
+        tasks.append([this, result, fields](const Done &done) {
+            backend->fetchRawAsync(result.value("phone").toString(), [this, result, fields, done](const ApiClient::Result &raw) {
+                if (raw.fromCache) {
+                    return;
+                }
+                const QVector<Records::ServiceRecord> records = raw.ok ? Records::decodeRows(raw.rows) : QVector<Records::ServiceRecord>();
+                const int latest = Records::latestCreatedIndex(records);
+                if (latest < 0) {
+                    QJsonObject line = result;
+                    line.insert("ok", false);
+                    line.insert("error", raw.ok ? QString("❌ 查無此電話資料，無法建立更換紀錄") : raw.message);
+                    emitJson(line);
+                    done();
+                    return;
+                }
+                const QJsonObject data = RecordInput::waterReplacement(fields.at(0), records.at(latest).customerName,
+                                                                       records.at(latest).address, DateUtils::parseYmd(fields.at(1)),
+                                                                       fields.at(2), fields.at(3));
+                QJsonObject line = result;
+                line.insert("next_replace_date_roc", data.value("next_replace_date_roc"));
+                post(line, data, done);
+            });
+        });
+    }
+    runTasks(tasks, options.concurrency);
+    return failures == 0 ? 0 : 1;
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Maintenance Log command line.\n"
+        "  query    look up customers; input lines hold a phone (or {\"phone\": ...})\n"
+        "  due      list filter changes and warranty ends falling due for the given customers\n"
+        "  submit   validate and post records from CSV, JSON or JSONL (same rules as 批次匯入)\n"
+        "  replace  post water-filter replacements; lines are phone,replace_date,cycle[,note] or JSON objects");
+    parser.addHelpOption();
+    parser.addPositionalArgument("command", "query, due, submit or replace.");
+    parser.addPositionalArgument("inputs", "Input files; '-' or none reads stdin.", "[files...]");
+    QCommandLineOption outputOption("output", "Write results to this file instead of stdout.", "path");
+    QCommandLineOption formatOption("format", "Output format: jsonl (default), csv, or xlsx (query only).", "format", "jsonl");
+    QCommandLineOption inputFormatOption("input-format", "submit input format: csv, json or jsonl (default: file extension).", "format");
+    QCommandLineOption concurrencyOption("concurrency", "Requests in flight at once.", "count", QString::number(kDefaultConcurrency));
+    QCommandLineOption onlyWaterOption("only-water", "query: keep only water-filter records.");
+    QCommandLineOption fromOption("from", "due: first day of the window, YYYY-MM-DD (default today).", "date");
+    QCommandLineOption daysOption("days", "due: length of the window in days.", "days", QString::number(kDefaultDueDays));
+    QCommandLineOption dryRunOption("dry-run", "submit/replace: print the records instead of posting them.");
+    QCommandLineOption endpointOption("endpoint", "Override the endpoint URL (default: MAINTENANCE_LOG_ENDPOINT or the built-in one).", "url");
+    QCommandLineOption localOption("local", "Use the local store instead of the endpoint (same as MAINTENANCE_LOG_BACKEND=local).");
+    parser.addOptions({outputOption, formatOption, inputFormatOption, concurrencyOption, onlyWaterOption, fromOption,
+                       daysOption, dryRunOption, endpointOption, localOption});
+    parser.process(app);
+
+    QStringList arguments = parser.positionalArguments();
+    const QString command = arguments.isEmpty() ? QString() : arguments.takeFirst();
+    if (!QStringList{"query", "due", "submit", "replace"}.contains(command)) {
+        parser.showHelp(2);
+    }
+    if (arguments.isEmpty()) {
+        arguments.append("-");
+    }
+
+    Options options;
+    options.concurrency = qMax(1, parser.value(concurrencyOption).toInt());
+    options.onlyWater = parser.isSet(onlyWaterOption);
+    options.dryRun = parser.isSet(dryRunOption);
+    options.format = parser.value(formatOption).toLower();
+    options.dueDays = qMax(0, parser.value(daysOption).toInt());
+    options.endpoint = parser.value(endpointOption);
+    options.local = parser.isSet(localOption) || LocalBackend::requested();
+    options.dueFrom = parser.isSet(fromOption) ? DateUtils::parseYmd(parser.value(fromOption)) : QDate::currentDate();
+    if (!options.dueFrom.isValid()) {
+        std::fprintf(stderr, "--from must be YYYY-MM-DD\n");
+        return 2;
+    }
+    if (!QStringList{"jsonl", "csv", "xlsx"}.contains(options.format) || (options.format == "xlsx" && command != "query")) {
+        std::fprintf(stderr, "unsupported --format for %s\n", qPrintable(command));
+        return 2;
+    }
+
+    QList<QPair<QString, QByteArray>> sources;
+    QVector<Input> inputs;
+    for (const auto &path : std::as_const(arguments)) {
+        QByteArray content;
+        QString error;
+        if (!readSource(path, &content, &error)) {
+            std::fprintf(stderr, "%s\n", qPrintable(error));
+            return 2;
+        }
+        inputs += splitLines(path, content);
+        sources.append(qMakePair(path, content));
+    }
+
+    const QString outputPath = parser.value(outputOption);
+    QFile out(outputPath);
+    const bool opened = outputPath.isEmpty() ? out.open(stdout, QIODevice::WriteOnly) : out.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    if (!opened) {
+        std::fprintf(stderr, "cannot write %s\n", qPrintable(outputPath));
+        return 2;
+    }
+
+    Cli cli(out, options);
+    if (command == "query") {
+        return cli.query(inputs);
+    }
+    if (command == "due") {
+        return cli.due(inputs);
+    }
+    if (command == "submit") {
+        return cli.submit(sources, parser.value(inputFormatOption).toLower());
+    }
+    return cli.replace(inputs);
+}
@@ -0,0 +1,52 @@
+#include "Compression.h"
+
+#include <array>
+
+namespace Compression {
+
+namespace {
+void appendLittleEndian32(QByteArray &out, quint32 value) {
+    for (int i = 0; i < 4; ++i) {
+        out.append(char((value >> (8 * i)) & 0xff));
+    }
+}
+} // namespace
+
+quint32 crc32(QByteArrayView data, quint32 crc) {
+    static const std::array<quint32, 256> table = [] {
+        std::array<quint32, 256> values{};
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            values[i] = c;
+        }
+        return values;
+    }();
+
+    crc = ~crc;
+    for (const char byte : data) {
+        crc = table[(crc ^ quint8(byte)) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+QByteArray gzip(const QByteArray &data, int level) {
+    // qCompress emits a 4-byte length, a 2-byte zlib header, the deflate stream and a 4-byte Adler-32.
+    const QByteArray zlib = qCompress(data, level);
+    if (data.isEmpty() || zlib.size() < 10) {
+        return {};
+    }
+
+    static const char kHeader[10] = {'\x1f', '\x8b', '\x08', 0, 0, 0, 0, 0, 0, '\xff'};
+    QByteArray out;
+    out.reserve(zlib.size() + 8);
+    out.append(kHeader, sizeof(kHeader));
+    out.append(QByteArrayView(zlib).sliced(6, zlib.size() - 10));
+    appendLittleEndian32(out, crc32(data));
+    appendLittleEndian32(out, quint32(data.size()));
+    return out;
+}
+
+} // namespace Compression
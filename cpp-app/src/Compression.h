@@ -0,0 +1,9 @@
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+
+namespace Compression {
+quint32 crc32(QByteArrayView data, quint32 crc = 0);
+QByteArray gzip(const QByteArray &data, int level = -1);
+} // namespace Compression
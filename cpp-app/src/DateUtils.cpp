@@ -1,26 +1,94 @@
 #include "DateUtils.h"
 
-#include <QRegularExpression>
-
 namespace DateUtils {
 
+namespace {
+bool isAsciiDigit(QChar c) {
+    return c.unicode() >= '0' && c.unicode() <= '9';
+}
+
+bool isRocSeparator(QChar c) {
+    return c == QLatin1Char('.') || c == QLatin1Char('/') || c == QLatin1Char('-');
+}
+
+// Callers have already checked that the range is ASCII digits.
+int groupValue(QStringView text, qsizetype start, qsizetype length) {
+    int value = 0;
+    for (qsizetype i = start; i < start + length; ++i) {
+        value = value * 10 + (text[i].unicode() - '0');
+    }
+    return value;
+}
+
+qsizetype scanDigits(QStringView text, qsizetype pos, qsizetype maxDigits) {
+    qsizetype count = 0;
+    while (pos + count < text.size() && count <= maxDigits && isAsciiDigit(text[pos + count])) {
+        ++count;
+    }
+    return count;
+}
+
+bool matchesYmdAt(QStringView text, qsizetype pos) {
+    static const int kDigitMask[10] = {1, 1, 1, 1, 0, 1, 1, 0, 1, 1};
+    for (int i = 0; i < 10; ++i) {
+        const QChar c = text[pos + i];
+        if (kDigitMask[i] ? !isAsciiDigit(c) : c != QLatin1Char('-')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void writePadded(QChar *out, int value, int width) {
+    for (int i = width - 1; i >= 0; --i) {
+        out[i] = QChar(u'0' + value % 10);
+        value /= 10;
+    }
+}
+} // namespace
+
 bool isYmd(const QString &text) {
-    static const QRegularExpression re(R"(\d{4}-\d{2}-\d{2})");
-    return re.match(text.trimmed()).hasMatch();
+    const QStringView view(text);
+    for (qsizetype pos = 0; pos + 10 <= view.size(); ++pos) {
+        if (matchesYmdAt(view, pos)) {
+            return true;
+        }
+    }
+    return false;
 }
 
 QDate parseYmd(const QString &text) {
     if (!isYmd(text)) {
         return {};
     }
-    return QDate::fromString(text.trimmed(), "yyyy-MM-dd");
+    const QStringView view = QStringView(text).trimmed();
+    if (view.size() == 10 && view[4] == QLatin1Char('-') && view[7] == QLatin1Char('-')) {
+        bool ascii = true;
+        for (int i : {0, 1, 2, 3, 5, 6, 8, 9}) {
+            ascii = ascii && isAsciiDigit(view[i]);
+        }
+        if (ascii) {
+            return QDate(groupValue(view, 0, 4), groupValue(view, 5, 2), groupValue(view, 8, 2));
+        }
+    }
+    return QDate::fromString(view.toString(), "yyyy-MM-dd");
 }
 
 QString dateToIso(const QDate &date) {
     if (!date.isValid()) {
         return {};
     }
-    return date.toString("yyyy-MM-dd");
+    if (date.year() < 1 || date.year() > 9999) {
+        return date.toString("yyyy-MM-dd");
+    }
+    QString result(10, Qt::Uninitialized);
+    QChar *out = result.data();
+    writePadded(out, date.year(), 4);
+    out[4] = QLatin1Char('-');
+    writePadded(out + 5, date.month(), 2);
+    out[7] = QLatin1Char('-');
+    writePadded(out + 8, date.day(), 2);
+    return result;
 }
 
 QString dateToRoc(const QDate &date) {
@@ -28,10 +96,24 @@ QString dateToRoc(const QDate &date) {
         return {};
     }
     int rocYear = date.year() - 1911;
-    return QString("%1.%2.%3")
-        .arg(rocYear, 3, 10, QChar('0'))
-        .arg(date.month(), 2, 10, QChar('0'))
-        .arg(date.day(), 2, 10, QChar('0'));
+    if (rocYear < 0 || rocYear > 999) {
+        return QString("%1.%2.%3")
+            .arg(rocYear, 3, 10, QChar('0'))
+            .arg(date.month(), 2, 10, QChar('0'))
+            .arg(date.day(), 2, 10, QChar('0'));
+    }
+    return formatRoc(rocYear, date.month(), date.day());
+}
+
+QString formatRoc(int rocYear, int month, int day) {
+    QString result(9, Qt::Uninitialized);
+    QChar *out = result.data();
+    writePadded(out, rocYear, 3);
+    out[3] = QLatin1Char('.');
+    writePadded(out + 4, month, 2);
+    out[6] = QLatin1Char('.');
+    writePadded(out + 7, day, 2);
+    return result;
 }
 
 QDate addMonths(const QDate &date, int months) {
@@ -50,44 +132,86 @@ QDate addOneYear(const QDate &date) {
     return addMonths(date, 12);
 }
 
-QString normalizeRocStr(const QString &value) {
-    QString trimmed = value.trimmed();
-    if (trimmed.isEmpty()) {
-        return {};
+bool parseRocParts(QStringView value, int *year, int *month, int *day) {
+    const QStringView text = value.trimmed();
+    const qsizetype yearDigits = scanDigits(text, 0, 3);
+    if (yearDigits < 1 || yearDigits > 3 || yearDigits >= text.size() || !isRocSeparator(text[yearDigits])) {
+        return false;
     }
-    static const QRegularExpression re(R"(^\s*(\d{1,3})[./-](\d{1,2})[./-](\d{1,2})\s*$)");
-    auto match = re.match(trimmed);
-    if (!match.hasMatch()) {
-        return {};
+    const qsizetype monthStart = yearDigits + 1;
+    const qsizetype monthDigits = scanDigits(text, monthStart, 2);
+    const qsizetype monthEnd = monthStart + monthDigits;
+    if (monthDigits < 1 || monthDigits > 2 || monthEnd >= text.size() || !isRocSeparator(text[monthEnd])) {
+        return false;
+    }
+    const qsizetype dayStart = monthEnd + 1;
+    const qsizetype dayDigits = scanDigits(text, dayStart, 2);
+    if (dayDigits < 1 || dayDigits > 2 || dayStart + dayDigits != text.size()) {
+        return false;
     }
-    int year = match.captured(1).toInt();
-    int month = match.captured(2).toInt();
-    int day = match.captured(3).toInt();
-    return QString("%1.%2.%3")
-        .arg(year, 3, 10, QChar('0'))
-        .arg(month, 2, 10, QChar('0'))
-        .arg(day, 2, 10, QChar('0'));
+    *year = groupValue(text, 0, yearDigits);
+    *month = groupValue(text, monthStart, monthDigits);
+    *day = groupValue(text, dayStart, dayDigits);
+    return true;
 }
 
-QDate rocToAdDate(const QString &rocStr) {
-    QString normalized = normalizeRocStr(rocStr);
-    if (normalized.isEmpty()) {
+QString normalizeRocStr(const QString &value) {
+    int year = 0;
+    int month = 0;
+    int day = 0;
+    if (!parseRocParts(value, &year, &month, &day)) {
         return {};
     }
-    const QStringList parts = normalized.split('.');
-    if (parts.size() != 3) {
+    return formatRoc(year, month, day);
+}
+
+QDate rocToAdDate(const QString &rocStr) {
+    int year = 0;
+    int month = 0;
+    int day = 0;
+    if (!parseRocParts(rocStr, &year, &month, &day)) {
         return {};
     }
-    bool okYear = false;
-    bool okMonth = false;
-    bool okDay = false;
-    int year = parts[0].toInt(&okYear);
-    int month = parts[1].toInt(&okMonth);
-    int day = parts[2].toInt(&okDay);
-    if (!okYear || !okMonth || !okDay) {
+    return QDate(year + 1911, month, day);
+}
+
+QDate rocToAdDate(const QString &rocStr, QString *normalized) {
+    int year = 0;
+    int month = 0;
+    int day = 0;
+    if (!parseRocParts(rocStr, &year, &month, &day)) {
+        normalized->clear();
         return {};
     }
+    *normalized = formatRoc(year, month, day);
     return QDate(year + 1911, month, day);
 }
 
+QVector<QDate> rocToAdDates(const QStringList &values) {
+    QVector<QDate> dates;
+    dates.reserve(values.size());
+    for (const auto &value : values) {
+        dates.append(rocToAdDate(value));
+    }
+    return dates;
+}
+
+QStringList datesToRoc(const QVector<QDate> &dates) {
+    QStringList values;
+    values.reserve(dates.size());
+    for (const auto &date : dates) {
+        values.append(dateToRoc(date));
+    }
+    return values;
+}
+
+QStringList datesToIso(const QVector<QDate> &dates) {
+    QStringList values;
+    values.reserve(dates.size());
+    for (const auto &date : dates) {
+        values.append(dateToIso(date));
+    }
+    return values;
+}
+
 } // namespace DateUtils
@@ -2,14 +2,24 @@
 
 #include <QDate>
 #include <QString>
+#include <QStringList>
+#include <QStringView>
+#include <QVector>
 
 namespace DateUtils {
 bool isYmd(const QString &text);
 QDate parseYmd(const QString &text);
 QString dateToIso(const QDate &date);
 QString dateToRoc(const QDate &date);
+QString formatRoc(int rocYear, int month, int day);
 QDate addMonths(const QDate &date, int months);
 QDate addOneYear(const QDate &date);
+bool parseRocParts(QStringView value, int *year, int *month, int *day);
 QString normalizeRocStr(const QString &value);
 QDate rocToAdDate(const QString &rocStr);
+QDate rocToAdDate(const QString &rocStr, QString *normalized);
+
+QVector<QDate> rocToAdDates(const QStringList &values);
+QStringList datesToRoc(const QVector<QDate> &dates);
+QStringList datesToIso(const QVector<QDate> &dates);
 } // namespace DateUtils
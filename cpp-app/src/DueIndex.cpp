@@ -0,0 +1,100 @@
+#include "DueIndex.h"
+
+#include "DateUtils.h"
+
+void DueIndex::replaceCustomer(const QString &phone, const QVector<Records::ServiceRecord> &records) {
+    removeCustomer(phone);
+    for (const auto &record : records) {
+        addRecordFor(phone, record);
+    }
+}
+
+void DueIndex::addRecord(const Records::ServiceRecord &record) {
+    addRecordFor(record.phone.trimmed(), record);
+}
+
+void DueIndex::clear() {
+    byDay.clear();
+    customers.clear();
+}
+
+QVector<DueIndex::Entry> DueIndex::dueBetween(const QDate &from, const QDate &to) const {
+    const auto begin = from.isValid() ? byDay.lower_bound(from.toJulianDay()) : byDay.begin();
+    const auto end = to.isValid() ? byDay.upper_bound(to.toJulianDay()) : byDay.end();
+    QVector<Entry> entries;
+    for (auto it = begin; it != end; ++it) {
+        entries.append(it->second);
+    }
+    return entries;
+}
+
+int DueIndex::size() const {
+    return int(byDay.size());
+}
+
+void DueIndex::addRecordFor(const QString &phone, const Records::ServiceRecord &record) {
+    if (phone.isEmpty()) {
+        return;
+    }
+    Customer &customer = customers[phone];
+
+    // Only the newest water record carries the pending filter change; older ones were already replaced.
+    if (record.itemMask & Records::WaterItem) {
+        const bool newer = !customer.hasWater || record.serviceDay > customer.waterDay
+            || (record.serviceDay == customer.waterDay && record.createdMs > customer.waterCreatedMs);
+        if (newer) {
+            if (customer.hasFilter) {
+                byDay.erase(customer.filter);
+                customer.hasFilter = false;
+            }
+            customer.hasWater = true;
+            customer.waterDay = record.serviceDay;
+            customer.waterCreatedMs = record.createdMs;
+
+            QString dueRoc;
+            const QDate due = DateUtils::rocToAdDate(record.nextReplaceRoc, &dueRoc);
+            if (due.isValid()) {
+                customer.filter = insert(phone, record, FilterChange, due.toJulianDay(), dueRoc);
+                customer.hasFilter = true;
+            }
+        }
+    }
+
+    QString warrantyRoc;
+    const QDate warrantyEnd = DateUtils::rocToAdDate(record.warrantyEndRoc, &warrantyRoc);
+    if (warrantyEnd.isValid()) {
+        for (const auto &existing : std::as_const(customer.warranties)) {
+            if (existing->second.dueDay == warrantyEnd.toJulianDay() && existing->second.serviceDateRoc == record.serviceDateRoc) {
+                return;
+            }
+        }
+        customer.warranties.append(insert(phone, record, WarrantyEnd, warrantyEnd.toJulianDay(), warrantyRoc));
+    }
+}
+
+DueIndex::DayMap::iterator DueIndex::insert(const QString &phone, const Records::ServiceRecord &record, Kind kind,
+                                            qint64 dueDay, const QString &dueRoc) {
+    Entry entry;
+    entry.dueDay = dueDay;
+    entry.kind = kind;
+    entry.dueRoc = dueRoc;
+    entry.serviceDateRoc = record.serviceDateRoc;
+    entry.customerName = record.customerName;
+    entry.phone = phone;
+    entry.address = record.address;
+    return byDay.emplace(dueDay, entry);
+}
+
+void DueIndex::removeCustomer(const QString &phone) {
+    auto it = customers.find(phone);
+    if (it == customers.end()) {
+        return;
+    }
+    if (it->hasFilter) {
+        byDay.erase(it->filter);
+    }
+    for (const auto &warranty : std::as_const(it->warranties)) {
+        byDay.erase(warranty);
+    }
+    customers.erase(it);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <QDate>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+#include <map>
+
+#include "Records.h"
+
+class DueIndex {
+public:
+    enum Kind { FilterChange, WarrantyEnd };
+
+    struct Entry {
+        qint64 dueDay = 0;
+        Kind kind = FilterChange;
+        QString dueRoc;
+        QString serviceDateRoc;
+        QString customerName;
+        QString phone;
+        QString address;
+    };
+
+    void replaceCustomer(const QString &phone, const QVector<Records::ServiceRecord> &records);
+    void addRecord(const Records::ServiceRecord &record);
+    void clear();
+
+    QVector<Entry> dueBetween(const QDate &from, const QDate &to) const;
+    int size() const;
+
+private:
+    using DayMap = std::multimap<qint64, Entry>;
+
+    struct Customer {
+        QList<DayMap::iterator> warranties;
+        DayMap::iterator filter;
+        bool hasFilter = false;
+        bool hasWater = false;
+        qint64 waterDay = 0;
+        qint64 waterCreatedMs = 0;
+    };
+
+    void addRecordFor(const QString &phone, const Records::ServiceRecord &record);
+    DayMap::iterator insert(const QString &phone, const Records::ServiceRecord &record, Kind kind, qint64 dueDay,
+                            const QString &dueRoc);
+    void removeCustomer(const QString &phone);
+
+    DayMap byDay;
+    QHash<QString, Customer> customers;
+};
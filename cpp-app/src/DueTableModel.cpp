@@ -0,0 +1,57 @@
+#include "DueTableModel.h"
+
+DueTableModel::DueTableModel(QObject *parent)
+    : QAbstractTableModel(parent),
+      headers({"到期日(民國)", "類型", "剩餘天數", "姓名", "電話", "地址", "服務日期(民國)"}) {}
+
+void DueTableModel::setEntries(const QVector<DueIndex::Entry> &entries, const QDate &today) {
+    beginResetModel();
+    rows = entries;
+    todayDay = today.toJulianDay();
+    endResetModel();
+}
+
+int DueTableModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : int(rows.size());
+}
+
+int DueTableModel::columnCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : int(headers.size());
+}
+
+QVariant DueTableModel::data(const QModelIndex &index, int role) const {
+    if ((role != Qt::DisplayRole && role != Qt::ToolTipRole) || index.row() < 0 || index.row() >= rows.size()) {
+        return {};
+    }
+    const DueIndex::Entry &entry = rows.at(index.row());
+    switch (index.column()) {
+    case 0:
+        return entry.dueRoc;
+    case 1:
+        return entry.kind == DueIndex::FilterChange ? QStringLiteral("淨水更換") : QStringLiteral("保固到期");
+    case 2: {
+        const qint64 days = entry.dueDay - todayDay;
+        return days < 0 ? QString("已逾期 %1 天").arg(-days) : QString::number(days);
+    }
+    case 3:
+        return entry.customerName;
+    case 4:
+        return entry.phone;
+    case 5:
+        return entry.address;
+    case 6:
+        return entry.serviceDateRoc;
+    default:
+        return {};
+    }
+}
+
+QVariant DueTableModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (role != Qt::DisplayRole) {
+        return {};
+    }
+    if (orientation == Qt::Vertical) {
+        return section + 1;
+    }
+    return headers.value(section);
+}
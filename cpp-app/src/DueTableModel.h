@@ -0,0 +1,26 @@
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QStringList>
+#include <QVector>
+
+#include "DueIndex.h"
+
+class DueTableModel : public QAbstractTableModel {
+    Q_OBJECT
+
+public:
+    explicit DueTableModel(QObject *parent = nullptr);
+
+    void setEntries(const QVector<DueIndex::Entry> &entries, const QDate &today);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+    QVector<DueIndex::Entry> rows;
+    QStringList headers;
+    qint64 todayDay = 0;
+};
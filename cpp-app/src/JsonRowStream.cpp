@@ -0,0 +1,117 @@
+#include "JsonRowStream.h"
+
+#include <QJsonDocument>
+
+void JsonRowStream::feed(const QByteArray &bytes, QJsonArray *rows) {
+    if (error) {
+        return;
+    }
+
+    const char *data = bytes.constData();
+    const qsizetype size = bytes.size();
+    qsizetype rowStart = inRowElement ? 0 : -1;
+
+    for (qsizetype i = 0; i < size; ++i) {
+        const char c = data[i];
+
+        if (inString) {
+            if (escaped) {
+                escaped = false;
+            } else if (c == '\\') {
+                escaped = true;
+            } else if (c == '"') {
+                inString = false;
+                if (depth == 1) {
+                    lastString = currentString;
+                }
+            } else if (depth == 1) {
+                currentString += c;
+            }
+            if (!inRows) {
+                envelopeBytes += c;
+            }
+            continue;
+        }
+
+        switch (c) {
+        case '"':
+            inString = true;
+            currentString.clear();
+            break;
+        case '{':
+        case '[':
+            if (inRows && depth == 2 && c == '{') {
+                inRowElement = true;
+                rowStart = i;
+            }
+            ++depth;
+            if (!inRows && !rowsSeen && depth == 2 && c == '[' && lastString == "rows") {
+                envelopeBytes += c;
+                inRows = true;
+                rowsSeen = true;
+                continue;
+            }
+            break;
+        case '}':
+        case ']':
+            --depth;
+            if (depth < 0) {
+                error = true;
+                return;
+            }
+            if (inRowElement && depth == 2) {
+                pendingRow.append(data + rowStart, i - rowStart + 1);
+                rowStart = -1;
+                inRowElement = false;
+                emitRow(rows);
+                if (error) {
+                    return;
+                }
+            } else if (inRows && depth == 1) {
+                inRows = false;
+            }
+            break;
+        default:
+            break;
+        }
+
+        if (!inRows) {
+            envelopeBytes += c;
+        }
+    }
+
+    if (inRowElement && rowStart >= 0) {
+        pendingRow.append(data + rowStart, size - rowStart);
+    }
+}
+
+bool JsonRowStream::finish(QJsonObject *envelope) const {
+    if (error || depth != 0 || inString) {
+        return false;
+    }
+    QJsonDocument doc = QJsonDocument::fromJson(envelopeBytes);
+    if (!doc.isObject()) {
+        return false;
+    }
+    *envelope = doc.object();
+    return true;
+}
+
+bool JsonRowStream::failed() const {
+    return error;
+}
+
+qint64 JsonRowStream::rowCount() const {
+    return parsedRows;
+}
+
+void JsonRowStream::emitRow(QJsonArray *rows) {
+    QJsonDocument doc = QJsonDocument::fromJson(pendingRow);
+    pendingRow.clear();
+    if (!doc.isObject()) {
+        error = true;
+        return;
+    }
+    rows->append(doc.object());
+    ++parsedRows;
+}
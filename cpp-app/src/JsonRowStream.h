@@ -0,0 +1,30 @@
+#pragma once
+
+#include <QByteArray>
+#include <QJsonArray>
+#include <QJsonObject>
+
+class JsonRowStream {
+public:
+    void feed(const QByteArray &bytes, QJsonArray *rows);
+    bool finish(QJsonObject *envelope) const;
+
+    bool failed() const;
+    qint64 rowCount() const;
+
+private:
+    void emitRow(QJsonArray *rows);
+
+    QByteArray envelopeBytes;
+    QByteArray pendingRow;
+    QByteArray currentString;
+    QByteArray lastString;
+    int depth = 0;
+    qint64 parsedRows = 0;
+    bool inString = false;
+    bool escaped = false;
+    bool inRows = false;
+    bool rowsSeen = false;
+    bool inRowElement = false;
+    bool error = false;
+};
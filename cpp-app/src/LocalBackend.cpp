@@ -0,0 +1,461 @@
+#include "LocalBackend.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTimer>
+
+#include "DateUtils.h"
+#include "OutboxQueue.h"
+#include "Perf.h"
+#include "Records.h"
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <limits>
+
+namespace {
+const quint32 kIndexMagic = 0x4d4c4958; // "MLIX"
+const qint32 kIndexVersion = 3;
+const int kIndexSaveRecords = 1000;
+const int kMaxSyncPage = 5000;
+const qint64 kNoDay = std::numeric_limits<qint64>::min();
+
+qint64 dayOf(const QString &roc) {
+    const QDate date = DateUtils::rocToAdDate(roc);
+    return date.isValid() ? date.toJulianDay() : kNoDay;
+}
+
+bool flushToDisk(QFile &file) {
+    if (!file.flush()) {
+        return false;
+    }
+#ifdef Q_OS_WIN
+    return _commit(file.handle()) == 0;
+#else
+    return ::fsync(file.handle()) == 0;
+#endif
+}
+} // namespace
+
+LocalBackend::LocalBackend(const QString &directory, QObject *parent) : StorageBackend(parent) {
+    QElapsedTimer timer;
+    timer.start();
+
+    QString dir = directory;
+    if (dir.isEmpty()) {
+        // Not AppLocalDataLocation: the app and the command line must open the same store.
+        dir = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/MaintenanceLog/local";
+    }
+    QDir().mkpath(dir);
+    dataPath = dir + "/records.jsonl";
+    indexPath = dir + "/index.bin";
+
+    // Offsets are only valid while one process appends, so a second one is refused.
+    lock = std::make_unique<QLockFile>(dir + "/lock");
+    if (!lock->tryLock(0)) {
+        errorText = QString::fromUtf8("本機資料庫正由另一個程式使用中");
+        return;
+    }
+    data.setFileName(dataPath);
+    if (!data.open(QIODevice::ReadWrite | QIODevice::Append)) {
+        errorText = data.errorString();
+        return;
+    }
+    if (!loadIndex()) {
+        byPhone.clear();
+        bySequence.clear();
+        byDueDay.clear();
+        filterByPhone.clear();
+        newestWater.clear();
+        warrantiesByPhone.clear();
+        openStats.rebuilt = true;
+        indexFrom(0);
+    }
+    openStats.openMs = timer.elapsed();
+}
+
+LocalBackend::~LocalBackend() {
+    if (indexDirty) {
+        saveIndex();
+    }
+}
+
+bool LocalBackend::requested() {
+    return qEnvironmentVariable("MAINTENANCE_LOG_BACKEND").compare(QLatin1String("local"), Qt::CaseInsensitive) == 0;
+}
+
+void LocalBackend::setReplica(OutboxQueue *outbox) {
+    replica = outbox;
+}
+
+LocalBackend::Stats LocalBackend::stats() const {
+    Stats stats = openStats;
+    stats.records = bySequence.size();
+    stats.customers = byPhone.size();
+    stats.bytes = dataBytes;
+    return stats;
+}
+
+QString LocalBackend::lastError() const {
+    return errorText;
+}
+
+QVector<DueIndex::Entry> LocalBackend::dueBetween(const QDate &from, const QDate &to) const {
+    Perf::Scope scope("local.due");
+    const auto begin = from.isValid() ? byDueDay.lower_bound(from.toJulianDay()) : byDueDay.begin();
+    const auto end = to.isValid() ? byDueDay.upper_bound(to.toJulianDay()) : byDueDay.end();
+    QVector<DueIndex::Entry> entries;
+    for (auto it = begin; it != end; ++it) {
+        const LogEntry &logEntry = bySequence.at(it->second.sequence);
+        const Records::ServiceRecord record = Records::decode(readAt(logEntry.location));
+        DueIndex::Entry entry;
+        entry.dueDay = it->first;
+        entry.kind = it->second.kind;
+        DateUtils::rocToAdDate(entry.kind == DueIndex::FilterChange ? record.nextReplaceRoc : record.warrantyEndRoc,
+                               &entry.dueRoc);
+        entry.serviceDateRoc = record.serviceDateRoc;
+        entry.customerName = record.customerName;
+        entry.phone = record.phone.trimmed();
+        entry.address = record.address;
+        entries.append(entry);
+    }
+    return entries;
+}
+
+int LocalBackend::dueCount() const {
+    return int(byDueDay.size());
+}
+
+QString LocalBackend::dataFile() const {
+    return dataPath;
+}
+
+qint64 LocalBackend::committedBytes() const {
+    return dataBytes;
+}
+
+bool LocalBackend::isLocal() const {
+    return true;
+}
+
+bool LocalBackend::loadIndex() {
+    QFile file(indexPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    qint32 version = 0;
+    qint64 indexedBytes = 0;
+    qint64 count = 0;
+    in >> magic >> version >> indexedBytes >> count;
+    // An index that covers more than the log describes a different (or truncated) log.
+    if (magic != kIndexMagic || version != kIndexVersion || indexedBytes > data.size() || count < 0) {
+        return false;
+    }
+
+    bySequence.reserve(count);
+    for (qint64 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        LogEntry entry;
+        qint32 length = 0;
+        in >> entry.phone >> entry.location.offset >> length >> entry.serviceDay >> entry.createdMs
+            >> entry.nextReplaceDay >> entry.warrantyEndDay >> entry.water;
+        entry.location.length = length;
+        addEntry(entry);
+    }
+    if (in.status() != QDataStream::Ok) {
+        return false;
+    }
+
+    indexFrom(indexedBytes);
+    return true;
+}
+
+void LocalBackend::indexFrom(qint64 offset) {
+    data.seek(offset);
+    qint64 position = offset;
+    while (!data.atEnd()) {
+        const QByteArray line = data.readLine();
+        if (!line.endsWith('\n')) {
+            // A torn final line from a crash mid-append; it was never acknowledged.
+            data.resize(position);
+            break;
+        }
+        const QJsonObject row = QJsonDocument::fromJson(line).object();
+        if (!row.isEmpty()) {
+            addToIndex(row, {position, int(line.size() - 1)});
+        }
+        position += line.size();
+    }
+    dataBytes = position;
+}
+
+void LocalBackend::addToIndex(const QJsonObject &row, const Location &location) {
+    const Records::ServiceRecord record = Records::decode(row);
+    LogEntry entry;
+    entry.phone = row.value("phone").toString();
+    entry.location = location;
+    entry.serviceDay = record.serviceDay;
+    entry.createdMs = record.createdMs;
+    entry.nextReplaceDay = dayOf(record.nextReplaceRoc);
+    entry.warrantyEndDay = dayOf(record.warrantyEndRoc);
+    entry.water = record.itemMask & Records::WaterItem;
+    addEntry(entry);
+    indexDirty = true;
+}
+
+void LocalBackend::addEntry(const LogEntry &entry) {
+    auto it = byPhone.find(entry.phone);
+    if (it == byPhone.end()) {
+        it = byPhone.insert(entry.phone, {});
+    }
+    it->append(entry.location);
+
+    bySequence.append(entry);
+    bySequence.last().phone = it.key();
+    addDueDates(bySequence.size() - 1);
+}
+
+void LocalBackend::addDueDates(qint64 sequence) {
+    // The same rules as DueIndex::addRecord, so both give the same due list for the same records.
+    const LogEntry &entry = bySequence.at(sequence);
+    const QString phone = entry.phone.trimmed();
+    if (phone.isEmpty()) {
+        return;
+    }
+
+    if (entry.water) {
+        const auto newest = newestWater.constFind(phone);
+        const bool newer = newest == newestWater.constEnd()
+            || entry.serviceDay > bySequence.at(*newest).serviceDay
+            || (entry.serviceDay == bySequence.at(*newest).serviceDay && entry.createdMs > bySequence.at(*newest).createdMs);
+        if (newer) {
+            const auto filter = filterByPhone.find(phone);
+            if (filter != filterByPhone.end()) {
+                byDueDay.erase(*filter);
+                filterByPhone.erase(filter);
+            }
+            newestWater.insert(phone, sequence);
+            if (entry.nextReplaceDay != kNoDay) {
+                filterByPhone.insert(phone, byDueDay.emplace(entry.nextReplaceDay, DueRef{sequence, DueIndex::FilterChange}));
+            }
+        }
+    }
+
+    if (entry.warrantyEndDay != kNoDay) {
+        QSet<QPair<qint64, qint64>> &warranties = warrantiesByPhone[phone];
+        const QPair<qint64, qint64> key(entry.warrantyEndDay, entry.serviceDay);
+        if (!warranties.contains(key)) {
+            warranties.insert(key);
+            byDueDay.emplace(entry.warrantyEndDay, DueRef{sequence, DueIndex::WarrantyEnd});
+        }
+    }
+}
+
+bool LocalBackend::saveIndex() {
+    QSaveFile file(indexPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        errorText = file.errorString();
+        return false;
+    }
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << kIndexMagic << kIndexVersion << dataBytes << qint64(bySequence.size());
+    for (const auto &entry : std::as_const(bySequence)) {
+        out << entry.phone << entry.location.offset << qint32(entry.location.length) << entry.serviceDay << entry.createdMs
+            << entry.nextReplaceDay << entry.warrantyEndDay << entry.water;
+    }
+    if (!file.commit()) {
+        errorText = file.errorString();
+        return false;
+    }
+    indexDirty = false;
+    unsavedRecords = 0;
+    return true;
+}
+
+QList<StorageBackend::Result> LocalBackend::append(const QList<QJsonObject> &records) {
+    Perf::Scope scope("local.append");
+    QList<Result> results;
+    QList<QPair<QJsonObject, Location>> written;
+    for (const auto &record : records) {
+        Result result;
+        if (record.value("phone").toString().isEmpty() || record.value("created_at").toString().isEmpty()) {
+            result.message = QString::fromUtf8("❌ 新增失敗：缺少電話或建立時間");
+            result.rejected = true;
+            results.append(result);
+            continue;
+        }
+        const QByteArray line = QJsonDocument(record).toJson(QJsonDocument::Compact) + '\n';
+        if (!data.isOpen() || data.write(line) != line.size()) {
+            result.message = QString::fromUtf8("❌ 新增失敗：%1").arg(data.isOpen() ? data.errorString() : errorText);
+            results.append(result);
+            continue;
+        }
+        written.append(qMakePair(record, Location{dataBytes, int(line.size() - 1)}));
+        dataBytes += line.size();
+        result.ok = true;
+        result.message = QString::fromUtf8("✅ 新增成功");
+        results.append(result);
+    }
+    if (written.isEmpty()) {
+        return results;
+    }
+
+    // One fsync per call, so a batch costs the same as a single record.
+    if (!flushToDisk(data)) {
+        errorText = data.errorString();
+        for (auto &result : results) {
+            if (result.ok) {
+                result.ok = false;
+                result.message = QString::fromUtf8("❌ 新增失敗：%1").arg(errorText);
+            }
+        }
+        return results;
+    }
+    for (const auto &entry : written) {
+        addToIndex(entry.first, entry.second);
+        if (replica) {
+            replica->enqueue(entry.first);
+        }
+    }
+    unsavedRecords += written.size();
+    if (unsavedRecords >= kIndexSaveRecords) {
+        saveIndex();
+    }
+    return results;
+}
+
+QJsonObject LocalBackend::readAt(const Location &location) const {
+    return readAt(data, location);
+}
+
+QJsonObject LocalBackend::readAt(QFile &file, const Location &location) {
+    if (!file.seek(location.offset)) {
+        return {};
+    }
+    return QJsonDocument::fromJson(file.read(location.length)).object();
+}
+
+QJsonArray LocalBackend::readCustomer(const QString &phone) const {
+    QJsonArray rows;
+    const auto it = byPhone.constFind(phone);
+    if (it == byPhone.constEnd()) {
+        return rows;
+    }
+    for (const auto &location : *it) {
+        const QJsonObject row = readAt(location);
+        if (!row.isEmpty()) {
+            rows.append(row);
+        }
+    }
+    return rows;
+}
+
+StorageBackend::Ticket LocalBackend::deliver(const ResultHandler &handler, const Result &result) {
+    const Ticket ticket = ++nextTicket;
+    pendingTickets.insert(ticket);
+    QTimer::singleShot(0, this, [this, ticket, handler, result]() {
+        if (pendingTickets.remove(ticket)) {
+            handler(result);
+        }
+    });
+    return ticket;
+}
+
+void LocalBackend::postRecordAsync(const QJsonObject &record, ResultHandler handler) {
+    deliver(handler, append({record}).first());
+}
+
+void LocalBackend::postRecordsAsync(const QList<QJsonObject> &records, BatchHandler handler) {
+    BatchResult batch;
+    batch.records = append(records);
+    batch.ok = true;
+    for (const auto &result : std::as_const(batch.records)) {
+        if (!result.ok) {
+            batch.ok = false;
+            batch.message = result.message;
+            break;
+        }
+    }
+    QTimer::singleShot(0, this, [handler, batch]() {
+        handler(batch);
+    });
+}
+
+StorageBackend::Ticket LocalBackend::getRecordsAsync(const QString &phone, bool onlyWater, ResultHandler handler, RowsHandler onRows) {
+    // Like ApiClient, the whole history is returned and the caller applies the water filter.
+    Q_UNUSED(onlyWater);
+    Q_UNUSED(onRows);
+    return fetchRawAsync(phone, handler);
+}
+
+StorageBackend::Ticket LocalBackend::fetchRawAsync(const QString &phone, ResultHandler handler) {
+    Perf::Scope scope("local.lookup");
+    Result result;
+    result.ok = data.isOpen();
+    result.message = result.ok ? QString() : QString::fromUtf8("❌ 本機資料庫無法開啟：%1").arg(errorText);
+    result.rows = readCustomer(phone);
+    result.fetchedAt = QDateTime::currentDateTime();
+    return deliver(handler, result);
+}
+
+StorageBackend::Ticket LocalBackend::fetchRecentAsync(const QString &phone, qint64 maxAgeSecs, ResultHandler handler) {
+    // The store is always current, so there is no age to check.
+    Q_UNUSED(maxAgeSecs);
+    return fetchRawAsync(phone, handler);
+}
+
+StorageBackend::Ticket LocalBackend::fetchSyncPageAsync(const QString &after, int limit, ResultHandler handler) {
+    Perf::Scope scope("local.sync_page");
+    // The log only grows, so a record's position never changes and records added later always come after the cursor.
+    const qint64 begin = qBound<qint64>(0, after.toLongLong(), bySequence.size());
+    const qint64 end = qMin<qint64>(bySequence.size(), begin + qBound(1, limit, kMaxSyncPage));
+
+    Result result;
+    result.ok = data.isOpen();
+    result.message = result.ok ? QString() : QString::fromUtf8("❌ 本機資料庫無法開啟：%1").arg(errorText);
+    result.fetchedAt = QDateTime::currentDateTime();
+    for (qint64 i = begin; i < end; ++i) {
+        result.rows.append(readAt(bySequence.at(i).location));
+    }
+    result.hasMore = end < bySequence.size();
+    result.cursor = QString::number(end);
+    return deliver(handler, result);
+}
+
+void LocalBackend::cancel(Ticket ticket) {
+    pendingTickets.remove(ticket);
+}
+
+StorageBackend::CustomerSource LocalBackend::cachedCustomers() const {
+    // Records only ever go after the end of the log, so the snapshot's positions stay valid while appends continue.
+    const QHash<QString, QVector<Location>> phones = byPhone;
+    const QString path = dataPath;
+    return [phones, path](const CustomerVisitor &visit) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return;
+        }
+        for (auto it = phones.cbegin(); it != phones.cend(); ++it) {
+            QJsonArray rows;
+            for (const auto &location : *it) {
+                const QJsonObject row = readAt(file, location);
+                if (!row.isEmpty()) {
+                    rows.append(row);
+                }
+            }
+            visit(it.key(), rows);
+        }
+    };
+}
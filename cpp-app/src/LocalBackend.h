@@ -0,0 +1,121 @@
+#pragma once
+
+#include <QDate>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QLockFile>
+#include <QPair>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+#include <map>
+#include <memory>
+
+#include "DueIndex.h"
+#include "StorageBackend.h"
+
+class OutboxQueue;
+
+// Embedded store: an append-only JSONL log plus phone, log-order and due-date indexes, persisted next to it.
+class LocalBackend : public StorageBackend {
+    Q_OBJECT
+
+public:
+    explicit LocalBackend(const QString &directory = QString(), QObject *parent = nullptr);
+    ~LocalBackend() override;
+
+    struct Stats {
+        qint64 records = 0;
+        int customers = 0;
+        qint64 bytes = 0;
+        qint64 openMs = 0;
+        bool rebuilt = false;
+    };
+
+    // True when MAINTENANCE_LOG_BACKEND=local.
+    static bool requested();
+
+    // Every accepted record is also queued here, normally an outbox that drains to the endpoint.
+    void setReplica(OutboxQueue *outbox);
+    Stats stats() const;
+    QString lastError() const;
+
+    // Filter changes and warranty ends due in [from, to], the same entries DueIndex would hold for the whole log;
+    // an invalid date leaves that end open. Only the returned records are read from the log.
+    QVector<DueIndex::Entry> dueBetween(const QDate &from, const QDate &to) const;
+    int dueCount() const;
+    // The log and how much of it is committed, for reading it on another handle.
+    QString dataFile() const;
+    qint64 committedBytes() const;
+
+    void postRecordAsync(const QJsonObject &record, ResultHandler handler) override;
+    void postRecordsAsync(const QList<QJsonObject> &records, BatchHandler handler) override;
+    Ticket getRecordsAsync(const QString &phone, bool onlyWater, ResultHandler handler, RowsHandler onRows = RowsHandler()) override;
+    Ticket fetchRawAsync(const QString &phone, ResultHandler handler) override;
+    Ticket fetchRecentAsync(const QString &phone, qint64 maxAgeSecs, ResultHandler handler) override;
+    Ticket fetchSyncPageAsync(const QString &after, int limit, ResultHandler handler) override;
+    void cancel(Ticket ticket) override;
+
+    CustomerSource cachedCustomers() const override;
+    bool isLocal() const override;
+
+private:
+    struct Location {
+        qint64 offset = 0;
+        int length = 0;
+    };
+
+    // What the due-date index needs from a record, so it can be rebuilt from index.bin without reading the log.
+    struct LogEntry {
+        QString phone;
+        Location location;
+        qint64 serviceDay = 0;
+        qint64 createdMs = 0;
+        qint64 nextReplaceDay = 0;
+        qint64 warrantyEndDay = 0;
+        bool water = false;
+    };
+
+    struct DueRef {
+        qint64 sequence = 0;
+        DueIndex::Kind kind = DueIndex::FilterChange;
+    };
+    using DueMap = std::multimap<qint64, DueRef>;
+
+    bool loadIndex();
+    void indexFrom(qint64 offset);
+    void addToIndex(const QJsonObject &row, const Location &location);
+    void addEntry(const LogEntry &entry);
+    void addDueDates(qint64 sequence);
+    bool saveIndex();
+    QList<Result> append(const QList<QJsonObject> &records);
+    QJsonObject readAt(const Location &location) const;
+    static QJsonObject readAt(QFile &file, const Location &location);
+    QJsonArray readCustomer(const QString &phone) const;
+    Ticket deliver(const ResultHandler &handler, const Result &result);
+
+    QString dataPath;
+    QString indexPath;
+    std::unique_ptr<QLockFile> lock;
+    mutable QFile data;
+    qint64 dataBytes = 0;
+    QHash<QString, QVector<Location>> byPhone;
+    // Position in this vector is the record's sequence number, which is also the delta-sync cursor.
+    QVector<LogEntry> bySequence;
+    DueMap byDueDay;
+    // The pending filter change of each customer: the one of their newest water record.
+    QHash<QString, DueMap::iterator> filterByPhone;
+    QHash<QString, qint64> newestWater;
+    // Warranty ends already listed per customer, by (due day, service day).
+    QHash<QString, QSet<QPair<qint64, qint64>>> warrantiesByPhone;
+    bool indexDirty = false;
+    int unsavedRecords = 0;
+    Stats openStats;
+    QString errorText;
+    OutboxQueue *replica = nullptr;
+    QSet<Ticket> pendingTickets;
+    Ticket nextTicket = 0;
+};
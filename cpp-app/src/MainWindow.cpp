@@ -1,99 +1,77 @@
 #include "MainWindow.h"
 
+#include <QAbstractItemView>
 #include <QDate>
 #include <QDateTime>
-#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileDialog>
 #include <QGroupBox>
 #include <QHeaderView>
 #include <QHBoxLayout>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QProgressBar>
+#include <QShortcut>
+#include <QStandardPaths>
 #include <QPushButton>
 #include <QTableView>
 #include <QVBoxLayout>
+#include <QtConcurrent/QtConcurrentRun>
 
 #include <algorithm>
+#include <memory>
 
 #include "DateUtils.h"
+#include "Perf.h"
+#include "RecordInput.h"
+#include "Records.h"
 
-namespace {
-const QString kWaterItem = QStringLiteral("淨水設備");
-const QString kGasItem = QStringLiteral("瓦斯爐具器具");
-
-const QStringList kItems = {
-    QStringLiteral("淨水設備"),
-    QStringLiteral("瓦斯爐具器具"),
-    QStringLiteral("系統櫃廚具"),
-    QStringLiteral("水電及室內裝修工程"),
-    QStringLiteral("其他（自行輸入）")
-};
-
-const QStringList kPurposes = {QStringLiteral("安裝"), QStringLiteral("購買")};
-
-const QStringList kWaterCycles = {QStringLiteral("半年"), QStringLiteral("一年"), QStringLiteral("一年半"), QStringLiteral("兩年")};
-
-int cycleToMonths(const QString &cycle) {
-    if (cycle == QStringLiteral("半年")) {
-        return 6;
-    }
-    if (cycle == QStringLiteral("一年")) {
-        return 12;
-    }
-    if (cycle == QStringLiteral("一年半")) {
-        return 18;
-    }
-    if (cycle == QStringLiteral("兩年")) {
-        return 24;
-    }
-    return 0;
-}
-
-QStringList toStringList(const QJsonValue &value) {
-    if (value.isArray()) {
-        QStringList list;
-        for (const auto &item : value.toArray()) {
-            list.append(item.toString());
-        }
-        return list;
-    }
-
-    if (value.isString()) {
-        const QString text = value.toString();
-        if (text.trimmed().startsWith('[')) {
-            QJsonDocument doc = QJsonDocument::fromJson(text.toUtf8());
-            if (doc.isArray()) {
-                QStringList list;
-                for (const auto &item : doc.array()) {
-                    list.append(item.toString());
-                }
-                return list;
-            }
-        }
-    }
-    return {};
-}
+using Records::cycleToMonths;
+using Records::kItems;
+using Records::kOtherItem;
+using Records::kPurposes;
+using Records::kWaterCycles;
+using Records::kWaterItem;
 
-QString joinList(const QStringList &values) {
-    QStringList cleaned;
-    for (const auto &value : values) {
-        if (!value.trimmed().isEmpty()) {
-            cleaned.append(value.trimmed());
-        }
-    }
-    return cleaned.join(" / ");
+namespace {
+const qint64 kReuseMaxAgeSecs = 15 * 60;
+const int kLookupDebounceMs = 350;
+const int kSearchDebounceMs = 200;
+const int kCompletePhoneDigits = 10;
+const int kDefaultDueDays = 30;
+const int kMinCandidateDigits = 3;
+const int kMaxPhoneCandidates = 12;
+const int kMaxSearchResults = 500;
+const int kMaxImportIssues = 200;
+const int kPerfRefreshMs = 1000;
+
+// The local backend keeps its own outbox and import progress, so switching backends never hands one store's
+// queued records or resume point to the other.
+QString backendDirectory(bool local, const QString &name) {
+    return local ? QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/local-" + name : QString();
 }
-
-struct DisplayRow {
-    QStringList columns;
-};
-
 } // namespace
 
-MainWindow::MainWindow(QWidget *parent) : QWidget(parent) {
+MainWindow::MainWindow(QWidget *parent)
+    : QWidget(parent),
+      localBackend(LocalBackend::requested() ? std::make_unique<LocalBackend>() : nullptr),
+      backend(localBackend ? static_cast<StorageBackend *>(localBackend.get()) : &apiClient),
+      outbox(backend, backendDirectory(localBackend != nullptr, "outbox")),
+      importer(&outbox, backendDirectory(localBackend != nullptr, "import")),
+      syncEngine(backend) {
+    decodePool.setMaxThreadCount(1);
+    if (localBackend && qEnvironmentVariableIntValue("MAINTENANCE_LOG_REPLICATE") != 0) {
+        replicaOutbox = std::make_unique<OutboxQueue>(
+            &apiClient, QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/replica-outbox");
+        localBackend->setReplica(replicaOutbox.get());
+    }
     buildUi();
     refreshRocDate();
     refreshFollowups();
+    loadLocalIndexes();
+    syncEngine.start();
 }
 
 void MainWindow::buildUi() {
@@ -196,9 +174,9 @@ void MainWindow::buildUi() {
 
     auto *queryRow = new QHBoxLayout();
     queryPhoneInput = new QLineEdit(this);
-    queryPhoneInput->setPlaceholderText("例如：0912345678");
+    queryPhoneInput->setPlaceholderText("完整電話，或開頭／末幾碼，例如：0912345678、5678");
     onlyWaterCheckbox = new QCheckBox("只列出淨水設備", this);
-    queryRow->addWidget(new QLabel("電話（需輸入完整）：", this));
+    queryRow->addWidget(new QLabel("電話（可輸入開頭或末幾碼）：", this));
     queryRow->addWidget(queryPhoneInput);
     queryRow->addWidget(onlyWaterCheckbox);
     queryLayout->addLayout(queryRow);
@@ -206,24 +184,59 @@ void MainWindow::buildUi() {
     queryButton = new QPushButton("查詢", this);
     queryMessage = new QLineEdit(this);
     queryMessage->setReadOnly(true);
+    cacheStatsLabel = new QLabel(this);
     queryLayout->addWidget(queryButton);
     queryLayout->addWidget(queryMessage);
+    queryLayout->addWidget(cacheStatsLabel);
 
-    resultsModel = new QStandardItemModel(this);
+    resultsModel = new RecordTableModel(this);
     auto *resultsTable = new QTableView(this);
     resultsTable->setModel(resultsModel);
-    resultsTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+    resultsTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
+    resultsTable->horizontalHeader()->setStretchLastSection(true);
+    resultsTable->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
     queryLayout->addWidget(new QLabel("查詢結果（依民國日期降冪排序）", this));
     queryLayout->addWidget(resultsTable);
 
-    latestModel = new QStandardItemModel(this);
+    latestModel = new RecordTableModel(this);
+    latestModel->setRowLimit(1);
     auto *latestTable = new QTableView(this);
     latestTable->setModel(latestModel);
-    latestTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+    latestTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
+    latestTable->horizontalHeader()->setStretchLastSection(true);
     queryLayout->addWidget(new QLabel("最新一筆", this));
     queryLayout->addWidget(latestTable);
 
+    exportResultsButton = new QPushButton("💾 匯出查詢結果（CSV/Excel）", this);
+    queryLayout->addWidget(exportResultsButton);
+    connect(exportResultsButton, &QPushButton::clicked, this, &MainWindow::exportResults);
+
     connect(queryButton, &QPushButton::clicked, this, &MainWindow::queryRecords);
+    connect(queryPhoneInput, &QLineEdit::textEdited, &apiClient, &ApiClient::warmUp);
+    lookupTimer = new QTimer(this);
+    lookupTimer->setSingleShot(true);
+    lookupTimer->setInterval(kLookupDebounceMs);
+    connect(queryPhoneInput, &QLineEdit::textEdited, this, &MainWindow::scheduleLookup);
+    connect(lookupTimer, &QTimer::timeout, this, &MainWindow::queryRecords);
+
+    phoneCandidates = new QStandardItemModel(this);
+    phoneCompleter = new QCompleter(phoneCandidates, this);
+    phoneCompleter->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    phoneCompleter->setCompletionRole(Qt::UserRole);
+    phoneCompleter->setWidget(queryPhoneInput);
+    connect(queryPhoneInput, &QLineEdit::textEdited, this, &MainWindow::refreshPhoneCandidates);
+    connect(phoneCompleter, QOverload<const QModelIndex &>::of(&QCompleter::activated), this, [this](const QModelIndex &index) {
+        queryPhoneInput->setText(index.data(Qt::UserRole).toString());
+        queryRecords();
+    });
+    connect(onlyWaterCheckbox, &QCheckBox::toggled, this, [this](bool checked) {
+        if (!currentRecords) {
+            return;
+        }
+        shownOnlyWater = checked;
+        resultsModel->setRecords(currentRecords, checked);
+        latestModel->setRecords(currentRecords, checked);
+    });
 
     queryLayout->addWidget(new QLabel("✅ 淨水設備：更換/未更換（勾選已更換可直接新增一筆更換紀錄）", this));
 
@@ -255,13 +268,218 @@ void MainWindow::buildUi() {
 
     connect(replaceButton, &QPushButton::clicked, this, &MainWindow::waterReplace);
 
-    tabs->addTab(queryTab, "🔍 查詢（完整電話）");
+    tabs->addTab(queryTab, "🔍 查詢（電話／開頭或末幾碼）");
+
+    auto *dueTab = new QWidget(this);
+    auto *dueLayout = new QVBoxLayout(dueTab);
+    auto *dueRow = new QHBoxLayout();
+    dueDaysInput = new QSpinBox(this);
+    dueDaysInput->setRange(1, 3650);
+    dueDaysInput->setValue(kDefaultDueDays);
+    dueDaysInput->setSuffix(" 天內");
+    dueOverdueCheckbox = new QCheckBox("包含已逾期", this);
+    dueRow->addWidget(new QLabel("到期範圍：", this));
+    dueRow->addWidget(dueDaysInput);
+    dueRow->addWidget(dueOverdueCheckbox);
+    dueRow->addStretch();
+    dueLayout->addLayout(dueRow);
+
+    dueSummaryLabel = new QLabel(this);
+    dueLayout->addWidget(dueSummaryLabel);
+    syncStatusLabel = new QLabel(this);
+    dueLayout->addWidget(syncStatusLabel);
+    exportAllButton = new QPushButton("💾 匯出全部本機資料（CSV/Excel）", this);
+    dueLayout->addWidget(exportAllButton);
+    connect(exportAllButton, &QPushButton::clicked, this, &MainWindow::exportAll);
+
+    dueModel = new DueTableModel(this);
+    auto *dueTable = new QTableView(this);
+    dueTable->setModel(dueModel);
+    dueTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
+    dueTable->horizontalHeader()->setStretchLastSection(true);
+    dueTable->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    dueLayout->addWidget(new QLabel("淨水更換與保固到期（來源：本機已同步的客戶資料）", this));
+    dueLayout->addWidget(dueTable);
+
+    connect(dueDaysInput, &QSpinBox::valueChanged, this, &MainWindow::refreshDueList);
+    connect(dueOverdueCheckbox, &QCheckBox::toggled, this, &MainWindow::refreshDueList);
+    connect(&syncEngine, &SyncEngine::pageStored, this, &MainWindow::handleSyncedPage);
+    connect(&syncEngine, &SyncEngine::statusChanged, this, &MainWindow::refreshSyncStatus);
+
+    tabs->addTab(dueTab, "⏰ 到期提醒");
+
+    auto *searchTab = new QWidget(this);
+    auto *searchLayout = new QVBoxLayout(searchTab);
+    auto *searchRow = new QHBoxLayout();
+    searchInput = new QLineEdit(this);
+    searchInput->setPlaceholderText("搜尋備註、地址、其他項目，例如：RO膜 + 信義路");
+    searchInput->setClearButtonEnabled(true);
+    searchRow->addWidget(new QLabel("關鍵字：", this));
+    searchRow->addWidget(searchInput);
+    searchLayout->addLayout(searchRow);
+
+    searchSummaryLabel = new QLabel(this);
+    searchLayout->addWidget(searchSummaryLabel);
+
+    searchModel = new RecordTableModel(this);
+    auto *searchTable = new QTableView(this);
+    searchTable->setModel(searchModel);
+    searchTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
+    searchTable->horizontalHeader()->setStretchLastSection(true);
+    searchTable->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    searchLayout->addWidget(searchTable);
+
+    searchTimer = new QTimer(this);
+    searchTimer->setSingleShot(true);
+    searchTimer->setInterval(kSearchDebounceMs);
+    connect(searchInput, &QLineEdit::textChanged, searchTimer, qOverload<>(&QTimer::start));
+    connect(searchInput, &QLineEdit::returnPressed, this, &MainWindow::refreshSearch);
+    connect(searchTimer, &QTimer::timeout, this, &MainWindow::refreshSearch);
+
+    tabs->addTab(searchTab, "🔎 全文搜尋");
+
+    auto *importTab = new QWidget(this);
+    auto *importLayout = new QVBoxLayout(importTab);
+    importLayout->addWidget(new QLabel("支援 CSV（第一列為欄位名稱）、JSON 陣列與 JSONL；日期可用西元 YYYY-MM-DD 或民國 113.01.05", this));
+    auto *importRow = new QHBoxLayout();
+    importChooseButton = new QPushButton("📂 選擇檔案並檢查", this);
+    importStartButton = new QPushButton("⬆️ 開始/繼續上傳", this);
+    importPauseButton = new QPushButton("⏸️ 暫停", this);
+    importStartButton->setEnabled(false);
+    importPauseButton->setEnabled(false);
+    importRow->addWidget(importChooseButton);
+    importRow->addWidget(importStartButton);
+    importRow->addWidget(importPauseButton);
+    importRow->addStretch();
+    importLayout->addLayout(importRow);
+
+    importProgress = new QProgressBar(this);
+    importStatusLabel = new QLabel(this);
+    importSummary = new QTextEdit(this);
+    importSummary->setReadOnly(true);
+    importLayout->addWidget(importProgress);
+    importLayout->addWidget(importStatusLabel);
+    importLayout->addWidget(importSummary);
+
+    connect(importChooseButton, &QPushButton::clicked, this, &MainWindow::chooseImportFile);
+    connect(importStartButton, &QPushButton::clicked, this, [this]() {
+        importer.startUpload();
+        importStartButton->setEnabled(false);
+        importPauseButton->setEnabled(importer.isUploading());
+    });
+    connect(importPauseButton, &QPushButton::clicked, this, [this]() {
+        importer.pause();
+        importStartButton->setEnabled(true);
+        importPauseButton->setEnabled(false);
+        importStatusLabel->setText(QString("已暫停：已排入 %1 / %2 筆，下次可從這裡繼續")
+                                       .arg(importer.queued())
+                                       .arg(importer.parsed().records.size()));
+    });
+    connect(&importer, &BulkImporter::loaded, this, &MainWindow::handleImportLoaded);
+    connect(&importer, &BulkImporter::recordsQueued, this, &MainWindow::handleImportedRecords);
+    connect(&importer, &BulkImporter::progress, this, [this](int queued, int total) {
+        importProgress->setRange(0, qMax(1, total));
+        importProgress->setValue(queued);
+        if (importer.isUploading()) {
+            importStatusLabel->setText(QString("上傳中：已排入 %1 / %2 筆").arg(queued).arg(total));
+        }
+    });
+    connect(&importer, &BulkImporter::finished, this, [this]() {
+        importChooseButton->setEnabled(true);
+        importStartButton->setEnabled(false);
+        importPauseButton->setEnabled(false);
+        importStatusLabel->setText(QString("✅ 已全部排入上傳佇列（%1 筆），背景上傳中").arg(importer.queued()));
+    });
+
+    tabs->addTab(importTab, "📥 批次匯入");
+
+    diagnosticsTab = new QWidget(this);
+    auto *diagnosticsLayout = new QVBoxLayout(diagnosticsTab);
+    auto *perfRow = new QHBoxLayout();
+    perfEnabledCheckbox = new QCheckBox("啟用量測", this);
+    perfEnabledCheckbox->setChecked(Perf::enabled());
+    auto *perfResetButton = new QPushButton("清除", this);
+    auto *perfTraceButton = new QPushButton("匯出 Chrome trace", this);
+    perfRow->addWidget(perfEnabledCheckbox);
+    perfRow->addWidget(perfResetButton);
+    perfRow->addWidget(perfTraceButton);
+    perfRow->addStretch();
+    diagnosticsLayout->addLayout(perfRow);
+
+    perfStatusLabel = new QLabel(this);
+    diagnosticsLayout->addWidget(perfStatusLabel);
+    perfModel = new QStandardItemModel(0, 7, this);
+    perfModel->setHorizontalHeaderLabels({"階段", "次數", "p50 (ms)", "p95 (ms)", "p99 (ms)", "最大 (ms)", "總計 (ms)"});
+    auto *perfTable = new QTableView(this);
+    perfTable->setModel(perfModel);
+    perfTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
+    perfTable->horizontalHeader()->setStretchLastSection(true);
+    perfTable->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    diagnosticsLayout->addWidget(perfTable);
+
+    perfTimer = new QTimer(this);
+    perfTimer->setInterval(kPerfRefreshMs);
+    connect(perfTimer, &QTimer::timeout, this, &MainWindow::refreshPerfStats);
+    connect(perfEnabledCheckbox, &QCheckBox::toggled, this, [this](bool checked) {
+        Perf::setEnabled(checked);
+        refreshPerfStats();
+    });
+    connect(perfResetButton, &QPushButton::clicked, this, [this]() {
+        Perf::reset();
+        refreshPerfStats();
+    });
+    connect(perfTraceButton, &QPushButton::clicked, this, &MainWindow::exportPerfTrace);
+    connect(tabs, &QTabWidget::currentChanged, this, [this]() {
+        if (tabs->currentWidget() == diagnosticsTab) {
+            refreshPerfStats();
+            perfTimer->start();
+        } else {
+            perfTimer->stop();
+        }
+    });
+
+    // The diagnostics tab stays hidden unless measuring is on at startup or Ctrl+Shift+D toggles it.
+    auto *diagnosticsShortcut = new QShortcut(QKeySequence("Ctrl+Shift+D"), this);
+    connect(diagnosticsShortcut, &QShortcut::activated, this, &MainWindow::toggleDiagnostics);
+    if (Perf::enabled()) {
+        tabs->addTab(diagnosticsTab, "📊 效能診斷");
+    } else {
+        diagnosticsTab->hide();
+    }
+
+    outboxStatusLabel = new QLabel(this);
+    connect(&outbox, &OutboxQueue::statusChanged, this, &MainWindow::refreshOutboxStatus);
+    connect(&outbox, &OutboxQueue::recordUploaded, this, &MainWindow::handleRecordUploaded);
+
+    auto *exportRow = new QHBoxLayout();
+    exportStatusLabel = new QLabel(this);
+    exportProgress = new QProgressBar(this);
+    exportCancelButton = new QPushButton("取消匯出", this);
+    exportRow->addWidget(exportStatusLabel);
+    exportRow->addWidget(exportProgress, 1);
+    exportRow->addWidget(exportCancelButton);
+    exportProgress->hide();
+    exportCancelButton->hide();
+    connect(exportCancelButton, &QPushButton::clicked, &exporter, &RecordExporter::cancel);
+    connect(&exporter, &RecordExporter::progress, this, [this](qint64 rows, qint64 expectedRows) {
+        if (expectedRows > 0) {
+            exportProgress->setRange(0, 1000);
+            exportProgress->setValue(int(qMin<qint64>(1000, rows * 1000 / expectedRows)));
+        }
+        exportStatusLabel->setText(QString("匯出中：%1 筆").arg(rows));
+    });
+    connect(&exporter, &RecordExporter::finished, this, &MainWindow::handleExportFinished);
 
     auto *mainLayout = new QVBoxLayout(this);
     mainLayout->addWidget(tabs);
+    mainLayout->addLayout(exportRow);
+    mainLayout->addWidget(outboxStatusLabel);
     setLayout(mainLayout);
 
     toggleFields();
+    refreshCacheStats();
+    refreshOutboxStatus();
+    refreshSyncStatus();
 }
 
 void MainWindow::refreshRocDate() {
@@ -278,27 +496,13 @@ void MainWindow::refreshFollowups() {
     QDate date = DateUtils::parseYmd(serviceDateInput->text().trimmed());
     QStringList items = selectedCheckboxes(itemBoxes);
 
-    QString nextReplace;
-    QString warrantyEnd;
-
-    if (date.isValid() && items.contains(kWaterItem)) {
-        int months = cycleToMonths(waterCycleCombo->currentText());
-        if (months > 0) {
-            nextReplace = DateUtils::dateToRoc(DateUtils::addMonths(date, months));
-        }
-    }
-
-    if (date.isValid() && items.contains(kGasItem)) {
-        warrantyEnd = DateUtils::dateToRoc(DateUtils::addOneYear(date));
-    }
-
-    nextReplaceInput->setText(nextReplace);
-    warrantyEndInput->setText(warrantyEnd);
+    nextReplaceInput->setText(RecordInput::nextReplaceRoc(date, items, waterCycleCombo->currentText()));
+    warrantyEndInput->setText(RecordInput::warrantyEndRoc(date, items));
 }
 
 void MainWindow::toggleFields() {
     QStringList items = selectedCheckboxes(itemBoxes);
-    bool showOther = items.contains("其他（自行輸入）");
+    bool showOther = items.contains(kOtherItem);
     bool showCycle = items.contains(kWaterItem);
 
     otherItemInput->setVisible(showOther);
@@ -317,231 +521,589 @@ QStringList MainWindow::selectedCheckboxes(const QList<QCheckBox *> &boxes) cons
 }
 
 void MainWindow::submitRecord() {
-    QString dateText = serviceDateInput->text().trimmed();
-    if (!DateUtils::isYmd(dateText)) {
-        submitResult->setText("❌ 日期格式錯誤，請用 YYYY-MM-DD");
+    RecordInput::Fields fields;
+    fields.serviceDate = serviceDateInput->text();
+    fields.customerName = nameInput->text();
+    fields.phone = phoneInput->text();
+    fields.address = addressInput->text();
+    fields.purposes = selectedCheckboxes(purposeBoxes);
+    fields.items = selectedCheckboxes(itemBoxes);
+    fields.otherItemText = otherItemInput->text();
+    fields.waterCycle = waterCycleCombo->currentText();
+    fields.nextReplaceRoc = nextReplaceInput->text();
+    fields.warrantyEndRoc = warrantyEndInput->text();
+    fields.notes = notesInput->toPlainText();
+
+    QString error;
+    const QJsonObject data = RecordInput::build(fields, &error);
+    if (data.isEmpty()) {
+        submitResult->setText(error);
         return;
     }
 
-    QDate date = DateUtils::parseYmd(dateText);
-    if (!date.isValid()) {
-        submitResult->setText("❌ 日期解析失敗，請確認 YYYY-MM-DD 是否為有效日期");
-        return;
-    }
+    enqueueRecord(data);
+    submitResult->setText("✅ 已存入本機，背景上傳中");
+}
 
-    if (nameInput->text().trimmed().isEmpty() || phoneInput->text().trimmed().isEmpty()) {
-        submitResult->setText("❌ 必填：姓名、電話");
-        return;
+void MainWindow::scheduleLookup() {
+    // A partial number only narrows the candidates from the phone index; the backend is asked once the number is
+    // complete, or known locally as a whole number, or when a candidate is picked.
+    const QString text = queryPhoneInput->text();
+    bool complete = PhoneIndex::normalize(text).size() >= kCompletePhoneDigits;
+    if (!complete) {
+        const QVector<PhoneIndex::Candidate> best = phoneIndex.lookup(text, 1);
+        complete = !best.isEmpty() && best.first().match == PhoneIndex::ExactMatch;
     }
-
-    QStringList purposes = selectedCheckboxes(purposeBoxes);
-    QStringList items = selectedCheckboxes(itemBoxes);
-
-    if (items.contains("其他（自行輸入）") && otherItemInput->text().trimmed().isEmpty()) {
-        submitResult->setText("❌ 你有勾選「其他（自行輸入）」但未填內容");
+    if (!complete) {
+        lookupTimer->stop();
         return;
     }
+    lookupTimer->start();
+}
 
-    QString waterCycle;
-    if (items.contains(kWaterItem)) {
-        waterCycle = waterCycleCombo->currentText();
-        if (cycleToMonths(waterCycle) <= 0) {
-            submitResult->setText("❌ 請選擇更換週期（半年/一年/一年半/兩年）");
-            return;
-        }
+void MainWindow::refreshPhoneCandidates(const QString &text) {
+    phoneCandidates->clear();
+    if (PhoneIndex::normalize(text).size() < kMinCandidateDigits) {
+        phoneCompleter->popup()->hide();
+        return;
     }
 
-    QJsonObject data;
-    data.insert("service_date_ad", DateUtils::dateToIso(date));
-    data.insert("service_date_roc", DateUtils::dateToRoc(date));
-    data.insert("customer_name", nameInput->text().trimmed());
-    data.insert("phone", phoneInput->text().trimmed());
-    data.insert("address", addressInput->text().trimmed());
-
-    QJsonArray purposeArray;
-    for (const auto &purpose : purposes) {
-        purposeArray.append(purpose);
+    for (const auto &candidate : phoneIndex.lookup(text, kMaxPhoneCandidates)) {
+        auto *item = new QStandardItem(QString("%1　%2　%3").arg(candidate.phone, candidate.customerName, candidate.address));
+        item->setData(candidate.phone, Qt::UserRole);
+        phoneCandidates->appendRow(item);
     }
-    data.insert("purposes", purposeArray);
-
-    QJsonArray itemArray;
-    for (const auto &item : items) {
-        itemArray.append(item);
+    if (phoneCandidates->rowCount() == 0) {
+        phoneCompleter->popup()->hide();
+        return;
     }
-    data.insert("items", itemArray);
-    data.insert("other_item_text", otherItemInput->text().trimmed());
-    data.insert("water_replace_cycle", waterCycle);
-    data.insert("next_replace_date_roc", nextReplaceInput->text().trimmed());
-    data.insert("warranty_end_date_roc", warrantyEndInput->text().trimmed());
-    data.insert("notes", notesInput->toPlainText().trimmed());
-    data.insert("created_at", QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss"));
-
-    submitButton->setEnabled(false);
-    submitResult->setText("⏳ 送出中...");
-
-    apiClient.postRecordAsync(data, [this](const ApiClient::Result &result) {
-        submitButton->setEnabled(true);
-        submitResult->setText(result.message);
-    });
+    phoneCompleter->complete();
 }
 
 void MainWindow::queryRecords() {
+    lookupTimer->stop();
+    backend->cancel(queryTicket);
+    const quint64 generation = ++queryGeneration;
+    // Rows a cancelled lookup already streamed in would otherwise be followed by this lookup's rows.
+    clearResults();
+
     QString phone = queryPhoneInput->text().trimmed();
     if (phone.isEmpty()) {
         queryMessage->setText("❌ 請輸入完整電話");
-        resultsModel->clear();
-        latestModel->clear();
         return;
     }
 
     bool onlyWater = onlyWaterCheckbox->isChecked();
-    queryButton->setEnabled(false);
     queryMessage->setText("⏳ 查詢中...");
+    const qint64 startNs = Perf::nowNs();
 
-    apiClient.getRecordsAsync(phone, onlyWater, [this, onlyWater](const ApiClient::Result &result) {
-        queryButton->setEnabled(true);
+    auto showingCache = std::make_shared<bool>(false);
+    auto streamedRows = std::make_shared<qsizetype>(0);
+    auto onRows = [this, generation, onlyWater, showingCache, streamedRows](const QJsonArray &chunk) {
+        if (generation != queryGeneration) {
+            return;
+        }
+        *streamedRows += chunk.size();
+        if (!*showingCache) {
+            appendStreamedRows(chunk, onlyWater);
+        }
+        // Streamed rows are shown in arrival order; they are sorted once the whole history is in.
+        queryMessage->setText(QString("⏳ 已載入 %1 筆，載入完成後排序...").arg(*streamedRows));
+    };
+
+    queryTicket = backend->getRecordsAsync(phone, onlyWater, [this, generation, phone, onlyWater, showingCache, startNs](const ApiClient::Result &result) {
+        if (generation != queryGeneration) {
+            return;
+        }
+        if (result.fromCache) {
+            *showingCache = true;
+            if (result.rows.isEmpty()) {
+                clearResults();
+            } else {
+                fillResults(result.rows, onlyWater, [this, phone, result]() {
+                    rememberResult(phone, result);
+                });
+            }
+            queryMessage->setText(result.message);
+            return;
+        }
+
+        refreshCacheStats();
         if (!result.ok) {
+            if (*showingCache) {
+                queryMessage->setText(QString("⚠️ 顯示快取資料，更新失敗：%1").arg(result.message));
+                return;
+            }
             queryMessage->setText(result.message);
-            resultsModel->clear();
-            latestModel->clear();
+            clearResults();
             return;
         }
 
         if (result.rows.isEmpty()) {
             queryMessage->setText("查無資料");
-            resultsModel->clear();
-            latestModel->clear();
+            clearResults();
             return;
         }
 
-        fillResults(result.rows, onlyWater);
-        queryMessage->setText("✅ 已依民國日期降冪排序");
-    });
+        fillResults(result.rows, onlyWater, [this, phone, result, startNs]() {
+            rememberResult(phone, result);
+            Perf::record("ui.query_total", startNs, Perf::nowNs() - startNs);
+            if (!currentRecords || resultsModel->rowCount() == 0) {
+                queryMessage->setText("查無資料");
+                return;
+            }
+            // An answer from the cache keeps saying so.
+            queryMessage->setText(result.message.isEmpty() ? QString("✅ 已依民國日期降冪排序")
+                                                           : QString("%1｜已依民國日期降冪排序").arg(result.message));
+        });
+    }, onRows);
 }
 
-void MainWindow::updateTable(QStandardItemModel *model, const QList<QStringList> &rows, const QStringList &headers) {
-    model->clear();
-    model->setColumnCount(headers.size());
-    model->setHorizontalHeaderLabels(headers);
+void MainWindow::refreshCacheStats() {
+    if (localBackend) {
+        const LocalBackend::Stats local = localBackend->stats();
+        QString text = QString("本機資料庫：%1 位客戶，%2 筆紀錄，%3 MB（開啟 %4 ms%5）")
+                           .arg(local.customers)
+                           .arg(local.records)
+                           .arg(local.bytes / (1024.0 * 1024.0), 0, 'f', 1)
+                           .arg(local.openMs)
+                           .arg(local.rebuilt ? QString("，已重建索引") : QString());
+        if (replicaOutbox) {
+            text += QString("\n同步至雲端：待上傳 %1 筆").arg(replicaOutbox->depth());
+            if (!replicaOutbox->lastError().isEmpty()) {
+                text += QString("｜稍後重試：%1").arg(replicaOutbox->lastError().section('\n', 0, 0));
+            }
+            if (replicaOutbox->rejectedCount() > 0) {
+                text += QString("｜雲端拒收 %1 筆（%2）")
+                            .arg(replicaOutbox->rejectedCount())
+                            .arg(QDir::toNativeSeparators(replicaOutbox->deadLetterFile()));
+            }
+        }
+        cacheStatsLabel->setText(text);
+        return;
+    }
+    const RecordCache::Stats stats = apiClient.cacheStats();
+    const double savedSeconds = stats.hits * apiClient.averageFetchMs() / 1000.0;
+    const ApiClient::NetworkStats network = apiClient.networkStats();
+    cacheStatsLabel->setText(QString("本機快取：%1 組查詢，命中 %2／未命中 %3，約省下 %4 秒等待\n"
+                                     "連線：%5 次請求，新建連線 %6（握手平均 %7 ms），HTTP/2 %8 次，轉址 %9 次，首位元組平均 %10 ms，DNS %11 ms，取消 %12 次\n"
+                                     "流量：上傳 %13 KB（原始 %14 KB），下載 %15 KB（解壓後 %16 KB）")
+                                 .arg(stats.entries)
+                                 .arg(stats.hits)
+                                 .arg(stats.misses)
+                                 .arg(savedSeconds, 0, 'f', 1)
+                                 .arg(network.requests)
+                                 .arg(network.newConnections)
+                                 .arg(network.avgHandshakeMs)
+                                 .arg(network.http2Requests)
+                                 .arg(network.redirects)
+                                 .arg(network.avgFirstByteMs)
+                                 .arg(network.dnsMs)
+                                 .arg(network.cancelled)
+                                 .arg(network.wireBytesSent / 1024.0, 0, 'f', 1)
+                                 .arg(network.bytesSent / 1024.0, 0, 'f', 1)
+                                 .arg(network.wireBytesReceived / 1024.0, 0, 'f', 1)
+                                 .arg(network.bytesReceived / 1024.0, 0, 'f', 1));
+}
+
+void MainWindow::fillResults(const QJsonArray &rows, bool onlyWater, const std::function<void()> &onShown) {
+    const quint64 generation = ++displayGeneration;
+    const QJsonArray previous = currentRecords ? shownRows : QJsonArray();
+    QtConcurrent::run(&decodePool, [rows, previous]() {
+        Perf::Scope scope("ui.decode_sort");
+        if (!previous.isEmpty() && rows == previous) {
+            return RecordTableModel::RecordList();
+        }
+        QVector<Records::ServiceRecord> records = Records::decodeRows(rows);
+        Records::sortNewestFirst(records);
+        Records::assignWaterRanks(records);
+        return RecordTableModel::RecordList(std::make_shared<const QVector<Records::ServiceRecord>>(std::move(records)));
+    }).then(this, [this, generation, rows, onlyWater, onShown](const RecordTableModel::RecordList &records) {
+        if (generation != displayGeneration) {
+            return;
+        }
+        Perf::Scope scope("ui.model_swap");
+        if (records) {
+            currentRecords = records;
+            shownRows = rows;
+        }
+        shownOnlyWater = onlyWater;
+        resultsModel->setRecords(currentRecords, onlyWater);
+        latestModel->setRecords(currentRecords, onlyWater);
+        if (onShown) {
+            onShown();
+        }
+    });
+}
 
-    for (const auto &row : rows) {
-        QList<QStandardItem *> items;
-        for (const auto &cell : row) {
-            items.append(new QStandardItem(cell));
+void MainWindow::appendStreamedRows(const QJsonArray &chunk, bool onlyWater) {
+    const quint64 generation = displayGeneration;
+    QtConcurrent::run(&decodePool, [chunk]() {
+        Perf::Scope scope("ui.decode_chunk");
+        return Records::decodeRows(chunk);
+    }).then(this, [this, generation, onlyWater](const QVector<Records::ServiceRecord> &records) {
+        if (generation != displayGeneration) {
+            return;
         }
-        model->appendRow(items);
+        Perf::Scope scope("ui.model_append");
+        currentRecords.reset();
+        currentPhone.clear();
+        shownRows = QJsonArray();
+        latestModel->clear();
+        resultsModel->appendRecords(records, onlyWater);
+    });
+}
+
+void MainWindow::rememberResult(const QString &phone, const ApiClient::Result &result) {
+    Perf::Scope scope("ui.index_update");
+    currentPhone = phone;
+    currentFetchedAt = result.fetchedAt;
+    if (currentRecords) {
+        indexCustomer(phone, *currentRecords);
+        refreshDueList();
+        refreshSearch();
     }
 }
 
-void MainWindow::fillResults(const QJsonArray &rows, bool onlyWater) {
-    struct Record {
-        QJsonObject obj;
-        QDate rocDate;
-        QDateTime createdAt;
-    };
+void MainWindow::enqueueRecord(const QJsonObject &data) {
+    outbox.enqueue(data);
+    indexRecords({Records::decode(data)});
+    refreshDueList();
+    refreshSearch();
+}
 
-    QVector<Record> records;
-    records.reserve(rows.size());
+void MainWindow::chooseImportFile() {
+    const QString path = QFileDialog::getOpenFileName(this, "選擇匯入檔案", QString(), "紀錄檔 (*.csv *.json *.jsonl)");
+    if (path.isEmpty() || !importer.load(path)) {
+        return;
+    }
+    importChooseButton->setEnabled(false);
+    importStartButton->setEnabled(false);
+    importProgress->setRange(0, 0);
+    importSummary->clear();
+    importStatusLabel->setText("檢查中...");
+}
 
-    for (const auto &value : rows) {
-        if (!value.isObject()) {
-            continue;
-        }
-        QJsonObject obj = value.toObject();
-        QString rocText = obj.value("service_date_roc").toString();
-        QString normalized = DateUtils::normalizeRocStr(rocText);
-        QDate rocDate = DateUtils::rocToAdDate(normalized);
-        QDateTime createdAt = QDateTime::fromString(obj.value("created_at").toString(), "yyyy-MM-dd HH:mm:ss");
+void MainWindow::handleImportLoaded() {
+    const BulkImporter::Parsed &parsed = importer.parsed();
+    importChooseButton->setEnabled(true);
+    importStartButton->setEnabled(importer.queued() < parsed.records.size());
+
+    QString text = QString("共 %1 列，可匯入 %2 筆，有問題 %3 列（檢查 %4 ms）")
+                       .arg(parsed.rows)
+                       .arg(parsed.records.size())
+                       .arg(parsed.issues.size())
+                       .arg(parsed.elapsedMs);
+    if (importer.queued() > 0) {
+        text += QString("\n上次已排入 %1 筆，將從第 %2 筆繼續").arg(importer.queued()).arg(importer.queued() + 1);
+    }
+    importStatusLabel->setText(text);
+
+    QStringList lines;
+    for (const auto &issue : parsed.issues.mid(0, kMaxImportIssues)) {
+        lines.append(QString("第 %1 列：%2").arg(issue.line).arg(issue.message));
+    }
+    if (parsed.issues.size() > kMaxImportIssues) {
+        lines.append(QString("...另有 %1 列未列出").arg(parsed.issues.size() - kMaxImportIssues));
+    }
+    importSummary->setPlainText(lines.join('\n'));
+}
 
-        records.push_back({obj, rocDate, createdAt});
+void MainWindow::handleImportedRecords(const QList<QJsonObject> &records) {
+    QVector<Records::ServiceRecord> decoded;
+    decoded.reserve(records.size());
+    for (const auto &data : records) {
+        decoded.append(Records::decode(data));
     }
+    indexRecords(decoded);
+    refreshDueList();
+    refreshSearch();
+}
 
-    std::sort(records.begin(), records.end(), [](const Record &a, const Record &b) {
-        if (a.rocDate != b.rocDate) {
-            return a.rocDate > b.rocDate;
+void MainWindow::loadLocalIndexes() {
+    // Reading and indexing everything stored locally can take seconds, so it runs on the pool while the window is up.
+    const quint64 generation = ++indexGeneration;
+    loadingIndexes = true;
+    changesWhileLoading.clear();
+    // The local store already holds every record, so a copy synced earlier from the endpoint is not mixed in.
+    const bool local = localBackend != nullptr;
+    const QString syncPath = syncEngine.store().recordsFile();
+    const qint64 syncBytes = local ? 0 : syncEngine.store().state().bytes;
+    const StorageBackend::CustomerSource customers = backend->cachedCustomers();
+    QtConcurrent::run(&decodePool, [local, syncPath, syncBytes, customers]() {
+        Perf::Scope scope("ui.load_indexes");
+        auto indexes = std::make_shared<LocalIndexes>();
+        DueIndex *due = local ? nullptr : &indexes->due;
+        IndexChange synced;
+        RecordStore::forEachIn(syncPath, syncBytes, [&synced](const QJsonObject &row) {
+            synced.records.append(Records::decode(row));
+            return true;
+        });
+        applyIndexChange(due, indexes->phones, indexes->search, synced);
+        customers([&indexes, due](const QString &phone, const QJsonArray &rows) {
+            applyIndexChange(due, indexes->phones, indexes->search, {phone, Records::decodeRows(rows)});
+        });
+        return indexes;
+    }).then(this, [this, generation](const std::shared_ptr<LocalIndexes> &indexes) {
+        if (generation != indexGeneration) {
+            return;
+        }
+        Perf::Scope scope("ui.index_swap");
+        for (const auto &change : std::as_const(changesWhileLoading)) {
+            applyIndexChange(localBackend ? nullptr : &indexes->due, indexes->phones, indexes->search, change);
         }
-        return a.createdAt > b.createdAt;
+        changesWhileLoading.clear();
+        loadingIndexes = false;
+        dueIndex = std::move(indexes->due);
+        phoneIndex = std::move(indexes->phones);
+        recordSearch = std::move(indexes->search);
+        refreshDueList();
+        refreshSearch();
     });
+}
 
-    QVector<int> waterIndices;
-    for (int i = 0; i < records.size(); ++i) {
-        QStringList items = toStringList(records[i].obj.value("items"));
-        if (items.contains(kWaterItem)) {
-            waterIndices.append(i);
+void MainWindow::indexRecords(const QVector<Records::ServiceRecord> &records) {
+    applyIndexChange({QString(), records});
+}
+
+void MainWindow::indexCustomer(const QString &phone, const QVector<Records::ServiceRecord> &records) {
+    applyIndexChange({phone, records});
+}
+
+void MainWindow::applyIndexChange(const IndexChange &change) {
+    if (loadingIndexes) {
+        changesWhileLoading.append(change);
+    }
+    applyIndexChange(localBackend ? nullptr : &dueIndex, phoneIndex, recordSearch, change);
+}
+
+void MainWindow::applyIndexChange(DueIndex *due, PhoneIndex &phones, RecordSearch &search, const IndexChange &change) {
+    if (change.phone.isEmpty()) {
+        for (const auto &record : change.records) {
+            if (due) {
+                due->addRecord(record);
+            }
+            phones.addRecord(record);
+            search.add(record);
         }
+        return;
+    }
+    if (due) {
+        due->replaceCustomer(change.phone, change.records);
     }
+    phones.setCustomer(change.phone, change.records);
+    for (const auto &record : change.records) {
+        search.add(record);
+    }
+}
 
-    QList<QStringList> displayRows;
-    displayRows.reserve(records.size());
+void MainWindow::handleSyncedPage(const QJsonArray &rows) {
+    indexRecords(Records::decodeRows(rows));
+    refreshDueList();
+    refreshSearch();
+}
 
-    for (int i = 0; i < records.size(); ++i) {
-        const auto &record = records[i];
-        const QJsonObject &obj = record.obj;
+void MainWindow::refreshSyncStatus() {
+    if (localBackend) {
+        const LocalBackend::Stats stats = localBackend->stats();
+        syncStatusLabel->setText(QString("資料同步：使用本機資料庫，共 %1 筆，不需同步").arg(stats.records));
+        return;
+    }
+    if (!syncEngine.isEnabled()) {
+        syncStatusLabel->setText("資料同步：未啟用（設定 MAINTENANCE_LOG_SYNC=1）");
+        return;
+    }
+    const RecordStore::State &state = syncEngine.store().state();
+    QString text = QString("資料同步：本機共 %1 筆，本次 %2 筆（%3 筆/秒）")
+                       .arg(state.records)
+                       .arg(syncEngine.runRecords())
+                       .arg(syncEngine.rowsPerSecond(), 0, 'f', 1);
+    if (syncEngine.isRunning()) {
+        text += "，同步中...";
+    } else if (state.lastSync.isValid()) {
+        text += QString("，上次完成 %1").arg(state.lastSync.toString("MM-dd HH:mm"));
+    }
+    if (!syncEngine.lastError().isEmpty()) {
+        text += QString("\n⚠️ %1（稍後重試）").arg(syncEngine.lastError());
+    }
+    syncStatusLabel->setText(text);
+}
 
-        QStringList purposes = toStringList(obj.value("purposes"));
-        QStringList items = toStringList(obj.value("items"));
+void MainWindow::refreshDueList() {
+    Perf::Scope scope("ui.due_refresh");
+    const QDate today = QDate::currentDate();
+    QElapsedTimer timer;
+    timer.start();
+    const QDate from = dueOverdueCheckbox->isChecked() ? QDate() : today;
+    const QDate to = today.addDays(dueDaysInput->value());
+    const QVector<DueIndex::Entry> entries = localBackend ? localBackend->dueBetween(from, to) : dueIndex.dueBetween(from, to);
+    const double elapsedMs = timer.nsecsElapsed() / 1e6;
+
+    dueModel->setEntries(entries, today);
+    dueSummaryLabel->setText(QString("共 %1 筆到期（索引 %2 筆，查詢 %3 ms）")
+                                 .arg(entries.size())
+                                 .arg(localBackend ? localBackend->dueCount() : dueIndex.size())
+                                 .arg(elapsedMs, 0, 'f', 3));
+}
 
-        if (onlyWater && !items.contains(kWaterItem)) {
-            continue;
-        }
+void MainWindow::refreshSearch() {
+    Perf::Scope scope("ui.search");
+    searchTimer->stop();
+    const TextIndex::Stats stats = recordSearch.indexStats();
+    const QString indexText = QString("索引 %1 筆、%2 個詞、約 %3 KB，資料約 %4 KB")
+                                  .arg(recordSearch.size())
+                                  .arg(stats.terms)
+                                  .arg(stats.approxBytes / 1024)
+                                  .arg(recordSearch.columnStats().approxBytes / 1024);
+    const QString query = searchInput->text().trimmed();
+    if (query.isEmpty()) {
+        searchModel->clear();
+        searchSummaryLabel->setText(indexText);
+        return;
+    }
 
-        QString itemsDisplay = onlyWater ? kWaterItem : joinList(items);
-
-        QString nextReplace = obj.value("next_replace_date_roc").toString().trimmed();
-        QString warrantyEnd = obj.value("warranty_end_date_roc").toString().trimmed();
-        QString followup;
-        if (onlyWater) {
-            followup = nextReplace.isEmpty() ? QString() : QString("更換：%1").arg(nextReplace);
-        } else if (!nextReplace.isEmpty() && !warrantyEnd.isEmpty()) {
-            followup = QString("更換：%1 / 保固：%2").arg(nextReplace, warrantyEnd);
-        } else if (!nextReplace.isEmpty()) {
-            followup = QString("更換：%1").arg(nextReplace);
-        } else if (!warrantyEnd.isEmpty()) {
-            followup = QString("保固：%1").arg(warrantyEnd);
-        }
+    QElapsedTimer timer;
+    timer.start();
+    int total = 0;
+    QVector<Records::ServiceRecord> records = recordSearch.search(query, kMaxSearchResults, &total);
+    const double elapsedMs = timer.nsecsElapsed() / 1e6;
 
-        QString waterStatus;
-        int waterIndex = waterIndices.indexOf(i);
-        if (waterIndex == 0) {
-            waterStatus = "未更換";
-        } else if (waterIndex > 0) {
-            waterStatus = "已更換";
-        }
+    searchModel->setRecords(std::make_shared<const QVector<Records::ServiceRecord>>(std::move(records)), false);
+    QString text = QString("共 %1 筆符合（查詢 %2 ms，%3）").arg(total).arg(elapsedMs, 0, 'f', 3).arg(indexText);
+    if (total > kMaxSearchResults) {
+        text += QString("\n僅顯示最新 %1 筆").arg(kMaxSearchResults);
+    }
+    searchSummaryLabel->setText(text);
+}
+
+void MainWindow::exportResults() {
+    const RecordTableModel::RecordList records = resultsModel->snapshot();
+    if (!records || records->isEmpty()) {
+        exportStatusLabel->setText("沒有可匯出的查詢結果");
+        return;
+    }
+    const bool onlyWater = resultsModel->isWaterOnly();
+    const qint64 expectedRows =
+        std::count_if(records->cbegin(), records->cend(), [onlyWater](const Records::ServiceRecord &record) {
+            return Records::matches(record, onlyWater);
+        });
+    const QString phone = currentPhone.isEmpty() ? queryPhoneInput->text().trimmed() : currentPhone;
+    startExport(QString("維修紀錄_%1").arg(phone), onlyWater, expectedRows,
+                [records, onlyWater](const RecordExporter::RowVisitor &visit) {
+                    for (const auto &record : *records) {
+                        if (Records::matches(record, onlyWater) && !visit(record)) {
+                            return;
+                        }
+                    }
+                });
+}
 
-        QString normalizedRoc = DateUtils::normalizeRocStr(obj.value("service_date_roc").toString());
-
-        displayRows.append({
-            normalizedRoc,
-            obj.value("customer_name").toString(),
-            obj.value("phone").toString(),
-            obj.value("address").toString(),
-            joinList(purposes),
-            itemsDisplay,
-            waterStatus,
-            followup,
-            obj.value("notes").toString()
+void MainWindow::exportAll() {
+    if (localBackend) {
+        const LocalBackend::Stats stats = localBackend->stats();
+        if (stats.records == 0) {
+            exportStatusLabel->setText("本機資料庫尚無資料");
+            return;
+        }
+        const QString path = localBackend->dataFile();
+        const qint64 bytes = localBackend->committedBytes();
+        startExport(QStringLiteral("維修紀錄_全部"), false, stats.records, [path, bytes](const RecordExporter::RowVisitor &visit) {
+            RecordStore::forEachIn(path, bytes, [&visit](const QJsonObject &row) {
+                return visit(Records::decode(row));
+            });
         });
+        return;
+    }
+    const RecordStore::State &state = syncEngine.store().state();
+    if (state.records == 0) {
+        exportStatusLabel->setText("本機尚無同步資料（設定 MAINTENANCE_LOG_SYNC=1 後同步）");
+        return;
     }
+    // The worker reads the committed part of the file on its own handle, so syncing can keep appending.
+    const QString path = syncEngine.store().recordsFile();
+    const qint64 bytes = state.bytes;
+    startExport(QStringLiteral("維修紀錄_全部"), false, state.records, [path, bytes](const RecordExporter::RowVisitor &visit) {
+        RecordStore::forEachIn(path, bytes, [&visit](const QJsonObject &row) {
+            return visit(Records::decode(row));
+        });
+    });
+}
 
-    QStringList headers = {
-        "日期(民國)",
-        "姓名",
-        "電話",
-        "地址",
-        "用途(安裝/購買)",
-        "項目",
-        "淨水狀態",
-        "更換日期或保固期限",
-        "備註"
-    };
+void MainWindow::startExport(const QString &baseName, bool onlyWater, qint64 expectedRows,
+                             const RecordExporter::RowSource &source) {
+    if (exporter.isRunning()) {
+        exportStatusLabel->setText("已有匯出正在進行");
+        return;
+    }
+    const QString fileName = QString("%1_%2.xlsx").arg(baseName, QDate::currentDate().toString("yyyyMMdd"));
+    const QString path = QFileDialog::getSaveFileName(this, "匯出", fileName, "Excel 活頁簿 (*.xlsx);;CSV (*.csv)");
+    if (path.isEmpty()) {
+        return;
+    }
 
-    updateTable(resultsModel, displayRows, headers);
+    exporter.start(path, RecordExporter::formatForPath(path), onlyWater, expectedRows, source);
+    exportProgress->setRange(0, 0);
+    exportProgress->show();
+    exportCancelButton->show();
+    exportResultsButton->setEnabled(false);
+    exportAllButton->setEnabled(false);
+    exportStatusLabel->setText("匯出中...");
+}
 
-    QList<QStringList> latest;
-    if (!displayRows.isEmpty()) {
-        latest.append(displayRows.first());
+void MainWindow::handleExportFinished(bool ok, qint64 rows, const QString &message) {
+    exportProgress->hide();
+    exportCancelButton->hide();
+    exportResultsButton->setEnabled(true);
+    exportAllButton->setEnabled(true);
+    exportStatusLabel->setText(ok ? QString("✅ 已匯出 %1 筆").arg(rows) : QString("⚠️ %1").arg(message));
+}
+
+void MainWindow::toggleDiagnostics() {
+    const int index = tabs->indexOf(diagnosticsTab);
+    if (index >= 0) {
+        tabs->removeTab(index);
+        diagnosticsTab->hide();
+        return;
     }
-    updateTable(latestModel, latest, headers);
+    tabs->addTab(diagnosticsTab, "📊 效能診斷");
+    tabs->setCurrentWidget(diagnosticsTab);
+}
+
+void MainWindow::refreshPerfStats() {
+    const QVector<Perf::StageStats> stages = Perf::snapshot();
+    perfModel->setRowCount(0);
+    for (const auto &stage : stages) {
+        QList<QStandardItem *> row;
+        row.append(new QStandardItem(stage.name));
+        row.append(new QStandardItem(QString::number(stage.count)));
+        for (double value : {stage.p50Ms, stage.p95Ms, stage.p99Ms, stage.maxMs, stage.totalMs}) {
+            row.append(new QStandardItem(QString::number(value, 'f', 3)));
+        }
+        perfModel->appendRow(row);
+    }
+    perfStatusLabel->setText(Perf::enabled() ? QString("量測中：%1 個階段（每秒更新）").arg(stages.size())
+                                             : QString("量測已關閉（設定 MAINTENANCE_LOG_PERF=1 可在啟動時開啟）"));
+}
+
+void MainWindow::exportPerfTrace() {
+    const QString fileName = QString("maintenance-log-trace_%1.json").arg(QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss"));
+    const QString path = QFileDialog::getSaveFileName(this, "匯出 Chrome trace", fileName, "Trace (*.json)");
+    if (path.isEmpty()) {
+        return;
+    }
+    QString error;
+    perfStatusLabel->setText(Perf::writeChromeTrace(path, &error)
+                                 ? QString("✅ 已匯出，可在 chrome://tracing 或 Perfetto 開啟：%1").arg(path)
+                                 : QString("⚠️ 匯出失敗：%1").arg(error));
+}
+
+void MainWindow::clearResults() {
+    ++displayGeneration;
+    currentRecords.reset();
+    currentPhone.clear();
+    shownRows = QJsonArray();
+    resultsModel->clear();
+    latestModel->clear();
 }
 
 void MainWindow::waterReplace() {
@@ -570,75 +1132,85 @@ void MainWindow::waterReplace() {
         return;
     }
 
+    QString customerName;
+    QString address;
+    if (findFreshCustomer(phone, &customerName, &address)) {
+        enqueueWaterReplacement(phone, customerName, address, replaceDateText, cycleChoice, extraNote);
+        return;
+    }
+
     replaceButton->setEnabled(false);
     replaceResult->setText("⏳ 讀取資料中...");
 
-    apiClient.fetchRawAsync(phone, [this, phone, replaceDateText, cycleChoice, extraNote](const ApiClient::Result &rawResult) {
+    // A cached copy from the last kReuseMaxAgeSecs is good enough; anything older is downloaded again.
+    backend->fetchRecentAsync(phone, kReuseMaxAgeSecs, [this, phone, replaceDateText, cycleChoice, extraNote](const ApiClient::Result &rawResult) {
+        replaceButton->setEnabled(true);
         if (!rawResult.ok) {
-            replaceButton->setEnabled(true);
             replaceResult->setText(QString("❌ 讀取原始資料失敗：%1").arg(rawResult.message));
             return;
         }
 
-        if (rawResult.rows.isEmpty()) {
-            replaceButton->setEnabled(true);
+        const QVector<Records::ServiceRecord> records = Records::decodeRows(rawResult.rows);
+        const int latest = Records::latestCreatedIndex(records);
+        if (latest < 0) {
             replaceResult->setText("❌ 查無此電話資料，無法建立更換紀錄");
             return;
         }
 
-        QJsonObject latestRecord;
-        QDateTime latestCreated;
-        for (const auto &value : rawResult.rows) {
-            if (!value.isObject()) {
-                continue;
-            }
-            QJsonObject obj = value.toObject();
-            QDateTime createdAt = QDateTime::fromString(obj.value("created_at").toString(), "yyyy-MM-dd HH:mm:ss");
-            if (!latestCreated.isValid() || createdAt > latestCreated) {
-                latestCreated = createdAt;
-                latestRecord = obj;
-            }
+        enqueueWaterReplacement(phone, records[latest].customerName, records[latest].address,
+                                replaceDateText, cycleChoice, extraNote);
+    });
+}
+
+bool MainWindow::findFreshCustomer(const QString &phone, QString *customerName, QString *address) {
+    if (currentRecords && currentPhone == phone
+        && currentFetchedAt.secsTo(QDateTime::currentDateTime()) <= kReuseMaxAgeSecs) {
+        const int latest = Records::latestCreatedIndex(*currentRecords);
+        if (latest >= 0) {
+            *customerName = currentRecords->at(latest).customerName;
+            *address = currentRecords->at(latest).address;
+            return true;
         }
+    }
+    return false;
+}
 
-        QDate replaceDate = DateUtils::parseYmd(replaceDateText);
-        QString nextReplace = DateUtils::dateToRoc(DateUtils::addMonths(replaceDate, cycleToMonths(cycleChoice)));
+void MainWindow::enqueueWaterReplacement(const QString &phone, const QString &customerName, const QString &address,
+                                         const QString &replaceDateText, const QString &cycleChoice, const QString &extraNote) {
+    const QJsonObject data = RecordInput::waterReplacement(phone, customerName, address, DateUtils::parseYmd(replaceDateText),
+                                                           cycleChoice, extraNote);
+    enqueueRecord(data);
+    replaceResult->setText(QString("✅ 已新增一筆『淨水設備更換』紀錄（下次更換：%1），背景上傳中")
+                               .arg(data.value("next_replace_date_roc").toString()));
+}
 
-        QString note = "淨水設備更換";
-        if (!extraNote.isEmpty()) {
-            note = QString("%1｜%2").arg(note, extraNote);
+void MainWindow::refreshOutboxStatus() {
+    QString text = QString("📤 待上傳：%1 筆｜上傳速率：%2 筆/分")
+                       .arg(outbox.depth())
+                       .arg(outbox.drainRatePerMinute(), 0, 'f', 0);
+    if (outbox.depth() > 0 && !outbox.lastError().isEmpty()) {
+        text += QString("｜稍後重試：%1").arg(outbox.lastError().section('\n', 0, 0));
+    }
+    if (outbox.rejectedCount() > 0) {
+        text += QString("\n⛔ 伺服器拒收 %1 筆，已移至 %2").arg(outbox.rejectedCount()).arg(QDir::toNativeSeparators(outbox.deadLetterFile()));
+        if (!outbox.lastRejection().isEmpty()) {
+            text += QString("｜最近：%1").arg(outbox.lastRejection().section('\n', 0, 0));
         }
+    }
+    outboxStatusLabel->setText(text);
+}
 
-        QJsonObject data;
-        data.insert("service_date_ad", DateUtils::dateToIso(replaceDate));
-        data.insert("service_date_roc", DateUtils::dateToRoc(replaceDate));
-        data.insert("customer_name", latestRecord.value("customer_name").toString());
-        data.insert("phone", phone);
-        data.insert("address", latestRecord.value("address").toString());
-
-        QJsonArray purposeArray;
-        purposeArray.append("安裝");
-        data.insert("purposes", purposeArray);
-
-        QJsonArray itemArray;
-        itemArray.append(kWaterItem);
-        data.insert("items", itemArray);
-        data.insert("other_item_text", "");
-        data.insert("water_replace_cycle", cycleChoice);
-        data.insert("next_replace_date_roc", nextReplace);
-        data.insert("warranty_end_date_roc", "");
-        data.insert("notes", note);
-        data.insert("created_at", QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss"));
-
-        replaceResult->setText("⏳ 新增更換紀錄中...");
-        apiClient.postRecordAsync(data, [this, nextReplace](const ApiClient::Result &postResult) {
-            replaceButton->setEnabled(true);
-            if (!postResult.ok) {
-                replaceResult->setText(QString("❌ 新增更換紀錄失敗：%1").arg(postResult.message));
-                return;
-            }
-
-            replaceResult->setText(QString("✅ 已新增一筆『淨水設備更換』紀錄（下次更換：%1）").arg(nextReplace));
-            queryRecords();
-        });
-    });
+void MainWindow::handleRecordUploaded(const QJsonObject &data) {
+    if (data.value("phone").toString() == queryPhoneInput->text().trimmed()) {
+        refreshAfterUpload = true;
+    }
+    if (refreshAfterUpload && outbox.depth() == 0) {
+        refreshAfterUpload = false;
+        queryRecords();
+    }
+    // The local store indexes due dates itself as records are written, so the list only needs redrawing.
+    if (localBackend && outbox.depth() == 0) {
+        refreshDueList();
+        refreshSyncStatus();
+    }
 }
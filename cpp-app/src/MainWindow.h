@@ -2,15 +2,33 @@
 
 #include <QCheckBox>
 #include <QComboBox>
+#include <QCompleter>
 #include <QLabel>
 #include <QLineEdit>
+#include <QProgressBar>
 #include <QPushButton>
+#include <QSpinBox>
 #include <QStandardItemModel>
 #include <QTabWidget>
 #include <QTextEdit>
+#include <QThreadPool>
+#include <QTimer>
 #include <QWidget>
 
+#include <functional>
+#include <memory>
+
 #include "ApiClient.h"
+#include "BulkImporter.h"
+#include "DueIndex.h"
+#include "DueTableModel.h"
+#include "LocalBackend.h"
+#include "OutboxQueue.h"
+#include "PhoneIndex.h"
+#include "RecordExporter.h"
+#include "RecordSearch.h"
+#include "RecordTableModel.h"
+#include "SyncEngine.h"
 
 class MainWindow : public QWidget {
     Q_OBJECT
@@ -19,19 +37,70 @@ public:
     explicit MainWindow(QWidget *parent = nullptr);
 
 private:
+    // The due, phone and full-text indexes over everything known locally. With the local backend the due list
+    // comes from its own date index, so `due` stays empty.
+    struct LocalIndexes {
+        DueIndex due;
+        PhoneIndex phones;
+        RecordSearch search;
+    };
+
+    // Records to add to the indexes; with a phone set they replace that customer's records instead.
+    struct IndexChange {
+        QString phone;
+        QVector<Records::ServiceRecord> records;
+    };
+
     void buildUi();
     void refreshRocDate();
     void refreshFollowups();
     void toggleFields();
     void submitRecord();
     void queryRecords();
+    void scheduleLookup();
+    void refreshPhoneCandidates(const QString &text);
     void waterReplace();
+    bool findFreshCustomer(const QString &phone, QString *customerName, QString *address);
+    void enqueueWaterReplacement(const QString &phone, const QString &customerName, const QString &address,
+                                 const QString &replaceDateText, const QString &cycleChoice, const QString &extraNote);
+    void refreshCacheStats();
+    void enqueueRecord(const QJsonObject &data);
+    void loadLocalIndexes();
+    void indexRecords(const QVector<Records::ServiceRecord> &records);
+    void indexCustomer(const QString &phone, const QVector<Records::ServiceRecord> &records);
+    void applyIndexChange(const IndexChange &change);
+    static void applyIndexChange(DueIndex *due, PhoneIndex &phones, RecordSearch &search, const IndexChange &change);
+    void refreshDueList();
+    void refreshSearch();
+    void exportResults();
+    void exportAll();
+    void startExport(const QString &baseName, bool onlyWater, qint64 expectedRows, const RecordExporter::RowSource &source);
+    void handleExportFinished(bool ok, qint64 rows, const QString &message);
+    void chooseImportFile();
+    void handleImportLoaded();
+    void handleImportedRecords(const QList<QJsonObject> &records);
+    void toggleDiagnostics();
+    void refreshPerfStats();
+    void exportPerfTrace();
+    void handleSyncedPage(const QJsonArray &rows);
+    void refreshSyncStatus();
+    void refreshOutboxStatus();
+    void handleRecordUploaded(const QJsonObject &data);
 
     QStringList selectedCheckboxes(const QList<QCheckBox *> &boxes) const;
-    void updateTable(QStandardItemModel *model, const QList<QStringList> &rows, const QStringList &headers);
-    void fillResults(const QJsonArray &rows, bool onlyWater);
+    void fillResults(const QJsonArray &rows, bool onlyWater, const std::function<void()> &onShown);
+    void appendStreamedRows(const QJsonArray &chunk, bool onlyWater);
+    void clearResults();
+    void rememberResult(const QString &phone, const ApiClient::Result &result);
 
     ApiClient apiClient;
+    std::unique_ptr<LocalBackend> localBackend;
+    StorageBackend *backend = nullptr;
+    std::unique_ptr<OutboxQueue> replicaOutbox;
+    OutboxQueue outbox;
+    BulkImporter importer;
+    SyncEngine syncEngine;
+    bool refreshAfterUpload = false;
 
     QTabWidget *tabs = nullptr;
 
@@ -52,10 +121,23 @@ private:
     QPushButton *submitButton = nullptr;
 
     QLineEdit *queryPhoneInput = nullptr;
+    QTimer *lookupTimer = nullptr;
+    PhoneIndex phoneIndex;
+    QCompleter *phoneCompleter = nullptr;
+    QStandardItemModel *phoneCandidates = nullptr;
+    ApiClient::Ticket queryTicket = 0;
+    quint64 queryGeneration = 0;
     QCheckBox *onlyWaterCheckbox = nullptr;
     QLineEdit *queryMessage = nullptr;
-    QStandardItemModel *resultsModel = nullptr;
-    QStandardItemModel *latestModel = nullptr;
+    QLabel *cacheStatsLabel = nullptr;
+    RecordTableModel *resultsModel = nullptr;
+    RecordTableModel *latestModel = nullptr;
+    RecordTableModel::RecordList currentRecords;
+    QString currentPhone;
+    QDateTime currentFetchedAt;
+    QJsonArray shownRows;
+    bool shownOnlyWater = false;
+    quint64 displayGeneration = 0;
     QPushButton *queryButton = nullptr;
 
     QCheckBox *replacedConfirm = nullptr;
@@ -64,4 +146,46 @@ private:
     QLineEdit *replaceNoteInput = nullptr;
     QLineEdit *replaceResult = nullptr;
     QPushButton *replaceButton = nullptr;
+
+    DueIndex dueIndex;
+    QSpinBox *dueDaysInput = nullptr;
+    QCheckBox *dueOverdueCheckbox = nullptr;
+    QLabel *dueSummaryLabel = nullptr;
+    QLabel *syncStatusLabel = nullptr;
+    DueTableModel *dueModel = nullptr;
+
+    RecordSearch recordSearch;
+    quint64 indexGeneration = 0;
+    bool loadingIndexes = false;
+    // Changes made while the startup load runs; they are replayed onto the indexes it builds.
+    QVector<IndexChange> changesWhileLoading;
+    QLineEdit *searchInput = nullptr;
+    QTimer *searchTimer = nullptr;
+    QLabel *searchSummaryLabel = nullptr;
+    RecordTableModel *searchModel = nullptr;
+
+    RecordExporter exporter;
+    QPushButton *exportResultsButton = nullptr;
+    QPushButton *exportAllButton = nullptr;
+    QPushButton *exportCancelButton = nullptr;
+    QProgressBar *exportProgress = nullptr;
+    QLabel *exportStatusLabel = nullptr;
+
+    QPushButton *importChooseButton = nullptr;
+    QPushButton *importStartButton = nullptr;
+    QPushButton *importPauseButton = nullptr;
+    QProgressBar *importProgress = nullptr;
+    QLabel *importStatusLabel = nullptr;
+    QTextEdit *importSummary = nullptr;
+
+    QWidget *diagnosticsTab = nullptr;
+    QCheckBox *perfEnabledCheckbox = nullptr;
+    QLabel *perfStatusLabel = nullptr;
+    QStandardItemModel *perfModel = nullptr;
+    QTimer *perfTimer = nullptr;
+
+    QLabel *outboxStatusLabel = nullptr;
+
+    // Decodes and sorts results off the GUI thread; one thread keeps streamed chunks in order.
+    QThreadPool decodePool;
 };
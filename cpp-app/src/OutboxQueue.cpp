@@ -0,0 +1,294 @@
+#include "OutboxQueue.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QJsonDocument>
+#include <QMap>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+const int kSyncIntervalMs = 25;
+const int kSyncBatchLines = 32;
+const int kUploadBatchSize = 100;
+const int kMinRetryMs = 1000;
+const int kMaxRetryMs = 5 * 60 * 1000;
+const qint64 kRateWindowMs = 60 * 1000;
+const qint64 kCompactBytes = 1024 * 1024;
+
+bool flushToDisk(QFile &file) {
+    if (!file.flush()) {
+        return false;
+    }
+#ifdef Q_OS_WIN
+    return _commit(file.handle()) == 0;
+#else
+    return ::fsync(file.handle()) == 0;
+#endif
+}
+} // namespace
+
+OutboxQueue::OutboxQueue(StorageBackend *client, const QString &directory, QObject *parent)
+    : QObject(parent), client(client) {
+    QString dir = directory;
+    if (dir.isEmpty()) {
+        dir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/outbox";
+    }
+    QDir().mkpath(dir);
+    journalPath = dir + "/journal.jsonl";
+    deadLetterPath = dir + "/dead-letter.jsonl";
+
+    QFile deadLetters(deadLetterPath);
+    if (deadLetters.open(QIODevice::ReadOnly)) {
+        while (!deadLetters.atEnd()) {
+            if (!deadLetters.readLine().trimmed().isEmpty()) {
+                ++rejected;
+            }
+        }
+    }
+
+    replayJournal();
+    compactJournal();
+
+    journal.setFileName(journalPath);
+    if (!journal.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        errorText = journal.errorString();
+    }
+
+    syncTimer.setSingleShot(true);
+    syncTimer.setInterval(kSyncIntervalMs);
+    connect(&syncTimer, &QTimer::timeout, this, &OutboxQueue::syncJournal);
+
+    retryTimer.setSingleShot(true);
+    connect(&retryTimer, &QTimer::timeout, this, &OutboxQueue::drain);
+
+    QTimer::singleShot(0, this, &OutboxQueue::drain);
+}
+
+OutboxQueue::~OutboxQueue() {
+    syncJournal();
+}
+
+void OutboxQueue::enqueue(const QJsonObject &data) {
+    Entry entry;
+    entry.id = nextId++;
+    entry.data = data;
+
+    QJsonObject line;
+    line.insert("op", "add");
+    line.insert("id", entry.id);
+    line.insert("data", data);
+    appendLine(line);
+
+    pending.enqueue(entry);
+    emit statusChanged(depth(), drainRatePerMinute());
+    drain();
+}
+
+void OutboxQueue::flush() {
+    syncJournal();
+}
+
+int OutboxQueue::depth() const {
+    return pending.size();
+}
+
+double OutboxQueue::drainRatePerMinute() const {
+    const qint64 cutoff = QDateTime::currentMSecsSinceEpoch() - kRateWindowMs;
+    int count = 0;
+    for (qint64 time : uploadTimes) {
+        if (time >= cutoff) {
+            ++count;
+        }
+    }
+    return count * 60000.0 / kRateWindowMs;
+}
+
+QString OutboxQueue::lastError() const {
+    return errorText;
+}
+
+int OutboxQueue::rejectedCount() const {
+    return rejected;
+}
+
+QString OutboxQueue::lastRejection() const {
+    return rejectionText;
+}
+
+QString OutboxQueue::deadLetterFile() const {
+    return deadLetterPath;
+}
+
+void OutboxQueue::replayJournal() {
+    QFile file(journalPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QMap<qint64, QJsonObject> entries;
+    while (!file.atEnd()) {
+        const QByteArray raw = file.readLine().trimmed();
+        if (raw.isEmpty()) {
+            continue;
+        }
+        const QJsonObject line = QJsonDocument::fromJson(raw).object();
+        const qint64 id = line.value("id").toInteger();
+        if (id <= 0) {
+            continue;
+        }
+        nextId = qMax(nextId, id + 1);
+        if (line.value("op").toString() == "add") {
+            entries.insert(id, line.value("data").toObject());
+        } else if (line.value("op").toString() == "ack") {
+            entries.remove(id);
+        }
+    }
+
+    for (auto it = entries.cbegin(); it != entries.cend(); ++it) {
+        Entry entry;
+        entry.id = it.key();
+        entry.data = it.value();
+        pending.enqueue(entry);
+    }
+}
+
+void OutboxQueue::compactJournal() {
+    QSaveFile file(journalPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    for (const auto &entry : pending) {
+        QJsonObject line;
+        line.insert("op", "add");
+        line.insert("id", entry.id);
+        line.insert("data", entry.data);
+        file.write(QJsonDocument(line).toJson(QJsonDocument::Compact) + '\n');
+    }
+    file.commit();
+}
+
+void OutboxQueue::appendLine(const QJsonObject &line) {
+    journal.write(QJsonDocument(line).toJson(QJsonDocument::Compact) + '\n');
+    ++unsyncedLines;
+    if (unsyncedLines >= kSyncBatchLines) {
+        syncJournal();
+    } else if (!syncTimer.isActive()) {
+        syncTimer.start();
+    }
+}
+
+void OutboxQueue::syncJournal() {
+    syncTimer.stop();
+    if (unsyncedLines == 0) {
+        return;
+    }
+    if (!flushToDisk(journal)) {
+        errorText = journal.errorString();
+    }
+    unsyncedLines = 0;
+}
+
+void OutboxQueue::drain() {
+    if (uploading || pending.isEmpty() || retryTimer.isActive()) {
+        return;
+    }
+    uploading = true;
+    uploadBatch(pending.mid(0, kUploadBatchSize));
+}
+
+void OutboxQueue::uploadBatch(const QList<Entry> &batch) {
+    QList<QJsonObject> records;
+    records.reserve(batch.size());
+    for (const auto &entry : batch) {
+        records.append(entry.data);
+    }
+
+    client->postRecordsAsync(records, [this, batch](const StorageBackend::BatchResult &result) {
+        QString failure = result.ok ? QString() : result.message;
+        for (int i = 0; i < batch.size(); ++i) {
+            const bool answered = i < result.records.size();
+            if (answered && result.records.at(i).ok) {
+                acknowledge(batch.at(i));
+            } else if (answered && result.records.at(i).rejected && deadLetter(batch.at(i), result.records.at(i).message)) {
+                continue;
+            } else if (failure.isEmpty()) {
+                failure = i < result.records.size() ? result.records.at(i).message : result.message;
+            }
+        }
+        finishBatch(failure.isEmpty(), failure);
+    });
+}
+
+void OutboxQueue::acknowledge(const Entry &entry) {
+    removeEntry(entry);
+
+    uploadTimes.append(QDateTime::currentMSecsSinceEpoch());
+    while (!uploadTimes.isEmpty() && uploadTimes.first() < uploadTimes.last() - kRateWindowMs) {
+        uploadTimes.removeFirst();
+    }
+
+    emit recordUploaded(entry.data);
+}
+
+bool OutboxQueue::deadLetter(const Entry &entry, const QString &error) {
+    QJsonObject line;
+    line.insert("id", entry.id);
+    line.insert("rejected_at", QDateTime::currentDateTime().toString(Qt::ISODate));
+    line.insert("error", error);
+    line.insert("data", entry.data);
+
+    // The record must be on disk here before the journal forgets it.
+    QFile file(deadLetterPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append) ||
+        file.write(QJsonDocument(line).toJson(QJsonDocument::Compact) + '\n') < 0 || !flushToDisk(file)) {
+        errorText = file.errorString();
+        return false;
+    }
+    removeEntry(entry);
+    ++rejected;
+    rejectionText = error;
+    return true;
+}
+
+void OutboxQueue::removeEntry(const Entry &entry) {
+    QJsonObject line;
+    line.insert("op", "ack");
+    line.insert("id", entry.id);
+    appendLine(line);
+
+    for (int i = 0; i < pending.size(); ++i) {
+        if (pending.at(i).id == entry.id) {
+            pending.removeAt(i);
+            break;
+        }
+    }
+}
+
+void OutboxQueue::finishBatch(bool ok, const QString &error) {
+    uploading = false;
+    if (ok) {
+        retryDelayMs = 0;
+        errorText.clear();
+        if (pending.isEmpty() && journal.size() > kCompactBytes) {
+            syncJournal();
+            journal.resize(0);
+        }
+        drain();
+    } else {
+        errorText = error;
+        scheduleRetry();
+    }
+    emit statusChanged(depth(), drainRatePerMinute());
+}
+
+void OutboxQueue::scheduleRetry() {
+    retryDelayMs = retryDelayMs == 0 ? kMinRetryMs : qMin(retryDelayMs * 2, kMaxRetryMs);
+    retryTimer.start(retryDelayMs);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <QFile>
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QQueue>
+#include <QTimer>
+
+#include "StorageBackend.h"
+
+class OutboxQueue : public QObject {
+    Q_OBJECT
+
+public:
+    explicit OutboxQueue(StorageBackend *client, const QString &directory = QString(), QObject *parent = nullptr);
+    ~OutboxQueue() override;
+
+    void enqueue(const QJsonObject &data);
+    void flush();
+
+    int depth() const;
+    double drainRatePerMinute() const;
+    QString lastError() const;
+    // Records the endpoint refused; they are moved to the dead-letter file instead of being retried.
+    int rejectedCount() const;
+    QString lastRejection() const;
+    QString deadLetterFile() const;
+
+signals:
+    void statusChanged(int depth, double drainRatePerMinute);
+    void recordUploaded(const QJsonObject &data);
+
+private:
+    struct Entry {
+        qint64 id = 0;
+        QJsonObject data;
+    };
+
+    void replayJournal();
+    void compactJournal();
+    void appendLine(const QJsonObject &line);
+    void syncJournal();
+    void drain();
+    void uploadBatch(const QList<Entry> &batch);
+    void acknowledge(const Entry &entry);
+    bool deadLetter(const Entry &entry, const QString &error);
+    void removeEntry(const Entry &entry);
+    void finishBatch(bool ok, const QString &error);
+    void scheduleRetry();
+
+    StorageBackend *client = nullptr;
+    QString journalPath;
+    QString deadLetterPath;
+    QFile journal;
+    QQueue<Entry> pending;
+    qint64 nextId = 1;
+    int unsyncedLines = 0;
+    bool uploading = false;
+    int retryDelayMs = 0;
+    QString errorText;
+    int rejected = 0;
+    QString rejectionText;
+    QList<qint64> uploadTimes;
+    QTimer syncTimer;
+    QTimer retryTimer;
+};
@@ -0,0 +1,206 @@
+#include "Perf.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QSaveFile>
+#include <QThread>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+
+namespace Perf {
+
+namespace {
+// Values below kLinearBuckets microseconds are exact; above that each power of two is split into 8 buckets (~12% error).
+const int kLinearBuckets = 16;
+const int kSubBuckets = 8;
+const int kBucketCount = kLinearBuckets + 40 * kSubBuckets;
+const int kMaxTraceEvents = 100000;
+
+struct Histogram {
+    std::array<qint64, kBucketCount> buckets{};
+    qint64 count = 0;
+    qint64 totalUs = 0;
+    qint64 maxUs = 0;
+};
+
+struct TraceEvent {
+    const char *name = nullptr;
+    qint64 startUs = 0;
+    qint64 durationUs = 0;
+    quintptr thread = 0;
+};
+
+struct Registry {
+    QMutex mutex;
+    QHash<QString, Histogram> stages;
+    QVector<TraceEvent> trace;
+    int traceNext = 0;
+};
+
+std::atomic_bool enabledFlag{qEnvironmentVariableIntValue("MAINTENANCE_LOG_PERF") != 0};
+
+Registry &registry() {
+    static Registry instance;
+    return instance;
+}
+
+const QElapsedTimer &clock() {
+    static const QElapsedTimer timer = [] {
+        QElapsedTimer started;
+        started.start();
+        return started;
+    }();
+    return timer;
+}
+
+int bucketFor(qint64 us) {
+    if (us < kLinearBuckets) {
+        return int(qMax<qint64>(us, 0));
+    }
+    const int exponent = 63 - qCountLeadingZeroBits(quint64(us));
+    const int sub = int((us >> (exponent - 3)) & (kSubBuckets - 1));
+    const int index = kLinearBuckets + (exponent - 4) * kSubBuckets + sub;
+    return qMin(index, kBucketCount - 1);
+}
+
+double bucketMidUs(int index) {
+    if (index < kLinearBuckets) {
+        return index;
+    }
+    const int exponent = (index - kLinearBuckets) / kSubBuckets + 4;
+    const int sub = (index - kLinearBuckets) % kSubBuckets;
+    const double width = double(qint64(1) << (exponent - 3));
+    return (kSubBuckets + sub) * width + width / 2;
+}
+
+double quantileMs(const Histogram &histogram, double quantile) {
+    const qint64 target = qMax<qint64>(1, qint64(histogram.count * quantile + 0.5));
+    qint64 seen = 0;
+    for (int i = 0; i < kBucketCount; ++i) {
+        seen += histogram.buckets[i];
+        if (seen >= target) {
+            return qMin(bucketMidUs(i), double(histogram.maxUs)) / 1000.0;
+        }
+    }
+    return histogram.maxUs / 1000.0;
+}
+} // namespace
+
+void setEnabled(bool enabled) {
+    enabledFlag.store(enabled, std::memory_order_relaxed);
+}
+
+bool enabled() {
+    return enabledFlag.load(std::memory_order_relaxed);
+}
+
+qint64 nowNs() {
+    return clock().nsecsElapsed();
+}
+
+void record(const char *name, qint64 startNs, qint64 durationNs) {
+    if (!enabled()) {
+        return;
+    }
+    const qint64 us = durationNs / 1000;
+    Registry &reg = registry();
+    QMutexLocker lock(&reg.mutex);
+    Histogram &histogram = reg.stages[QString::fromLatin1(name)];
+    ++histogram.buckets[bucketFor(us)];
+    ++histogram.count;
+    histogram.totalUs += us;
+    histogram.maxUs = qMax(histogram.maxUs, us);
+
+    const TraceEvent event{name, startNs / 1000, us, quintptr(QThread::currentThreadId())};
+    if (reg.trace.size() < kMaxTraceEvents) {
+        reg.trace.append(event);
+    } else {
+        reg.trace[reg.traceNext] = event;
+    }
+    reg.traceNext = (reg.traceNext + 1) % kMaxTraceEvents;
+}
+
+QVector<StageStats> snapshot() {
+    Registry &reg = registry();
+    QMutexLocker lock(&reg.mutex);
+    QVector<StageStats> stats;
+    stats.reserve(reg.stages.size());
+    for (auto it = reg.stages.cbegin(); it != reg.stages.cend(); ++it) {
+        StageStats stage;
+        stage.name = it.key();
+        stage.count = it->count;
+        stage.p50Ms = quantileMs(*it, 0.50);
+        stage.p95Ms = quantileMs(*it, 0.95);
+        stage.p99Ms = quantileMs(*it, 0.99);
+        stage.maxMs = it->maxUs / 1000.0;
+        stage.totalMs = it->totalUs / 1000.0;
+        stats.append(stage);
+    }
+    std::sort(stats.begin(), stats.end(), [](const StageStats &a, const StageStats &b) { return a.name < b.name; });
+    return stats;
+}
+
+void reset() {
+    Registry &reg = registry();
+    QMutexLocker lock(&reg.mutex);
+    reg.stages.clear();
+    reg.trace.clear();
+    reg.traceNext = 0;
+}
+
+bool writeChromeTrace(const QString &path, QString *error) {
+    QVector<TraceEvent> events;
+    {
+        Registry &reg = registry();
+        QMutexLocker lock(&reg.mutex);
+        events = reg.trace;
+    }
+
+    QHash<quintptr, int> threadIds;
+    QJsonArray traceEvents;
+    for (const auto &event : std::as_const(events)) {
+        const int tid = threadIds.value(event.thread, int(threadIds.size()) + 1);
+        threadIds.insert(event.thread, tid);
+        QJsonObject obj;
+        obj.insert("name", QString::fromLatin1(event.name));
+        obj.insert("cat", QString::fromLatin1(event.name).section('.', 0, 0));
+        obj.insert("ph", "X");
+        obj.insert("ts", event.startUs);
+        obj.insert("dur", event.durationUs);
+        obj.insert("pid", 1);
+        obj.insert("tid", tid);
+        traceEvents.append(obj);
+    }
+
+    QJsonObject root;
+    root.insert("traceEvents", traceEvents);
+    root.insert("displayTimeUnit", "ms");
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        *error = file.errorString();
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    if (!file.commit()) {
+        *error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+Scope::Scope(const char *name) : name(name), startNs(enabled() ? nowNs() : -1) {}
+
+Scope::~Scope() {
+    if (startNs >= 0) {
+        record(name, startNs, nowNs() - startNs);
+    }
+}
+
+} // namespace Perf
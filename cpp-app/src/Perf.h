@@ -0,0 +1,40 @@
+#pragma once
+
+#include <QString>
+#include <QVector>
+
+namespace Perf {
+struct StageStats {
+    QString name;
+    qint64 count = 0;
+    double p50Ms = 0;
+    double p95Ms = 0;
+    double p99Ms = 0;
+    double maxMs = 0;
+    double totalMs = 0;
+};
+
+// Off unless MAINTENANCE_LOG_PERF=1 or switched on from the diagnostics tab; a disabled scope costs one relaxed load.
+void setEnabled(bool enabled);
+bool enabled();
+
+qint64 nowNs();
+void record(const char *name, qint64 startNs, qint64 durationNs);
+
+QVector<StageStats> snapshot();
+void reset();
+bool writeChromeTrace(const QString &path, QString *error);
+
+class Scope {
+public:
+    explicit Scope(const char *name);
+    ~Scope();
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+private:
+    const char *name;
+    qint64 startNs;
+};
+} // namespace Perf
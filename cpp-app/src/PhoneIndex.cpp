@@ -0,0 +1,175 @@
+#include "PhoneIndex.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+QString reversedText(const QString &text) {
+    QString result(text.size(), Qt::Uninitialized);
+    std::reverse_copy(text.cbegin(), text.cend(), result.begin());
+    return result;
+}
+} // namespace
+
+void PhoneIndex::setCustomer(const QString &phone, const QVector<Records::ServiceRecord> &records) {
+    const int index = customerFor(phone);
+    if (index < 0) {
+        return;
+    }
+    Customer &customer = customers[index];
+    customer.records = 0;
+    customer.lastServiceDay = std::numeric_limits<qint64>::min();
+    customer.lastCreatedMs = std::numeric_limits<qint64>::min();
+    for (const auto &record : records) {
+        absorb(customer, record);
+    }
+}
+
+void PhoneIndex::addRecord(const Records::ServiceRecord &record) {
+    const int index = customerFor(record.phone);
+    if (index >= 0) {
+        absorb(customers[index], record);
+    }
+}
+
+void PhoneIndex::clear() {
+    customers.clear();
+    byDigits.clear();
+    prefixOrder.clear();
+    suffixOrder.clear();
+    sortedCount = 0;
+}
+
+QVector<PhoneIndex::Candidate> PhoneIndex::lookup(const QString &text, int limit) const {
+    const QString digits = normalize(text);
+    if (digits.isEmpty() || limit <= 0) {
+        return {};
+    }
+
+    sortPending();
+    QVector<int> prefixMatches;
+    QVector<int> suffixMatches;
+    collect(prefixOrder, false, digits, &prefixMatches);
+    collect(suffixOrder, true, reversedText(digits), &suffixMatches);
+
+    // Rank exact matches first, then prefix, then suffix; the most recently serviced customer wins within a group.
+    QVector<QPair<int, int>> ranked;
+    ranked.reserve(prefixMatches.size() + suffixMatches.size());
+    for (int index : std::as_const(prefixMatches)) {
+        ranked.append({customers.at(index).digits == digits ? ExactMatch : PrefixMatch, index});
+    }
+    for (int index : std::as_const(suffixMatches)) {
+        if (!customers.at(index).digits.startsWith(digits)) {
+            ranked.append({SuffixMatch, index});
+        }
+    }
+    const auto better = [this](const QPair<int, int> &a, const QPair<int, int> &b) {
+        if (a.first != b.first) {
+            return a.first < b.first;
+        }
+        const Customer &left = customers.at(a.second);
+        const Customer &right = customers.at(b.second);
+        if (left.lastServiceDay != right.lastServiceDay) {
+            return left.lastServiceDay > right.lastServiceDay;
+        }
+        return left.records > right.records;
+    };
+    const auto middle = ranked.begin() + qMin<qsizetype>(limit, ranked.size());
+    std::partial_sort(ranked.begin(), middle, ranked.end(), better);
+
+    QVector<Candidate> candidates;
+    for (auto it = ranked.begin(); it != middle; ++it) {
+        const Customer &customer = customers.at(it->second);
+        Candidate candidate;
+        candidate.phone = customer.phone;
+        candidate.customerName = customer.customerName;
+        candidate.address = customer.address;
+        candidate.lastServiceDay = customer.lastServiceDay;
+        candidate.records = customer.records;
+        candidate.match = Match(it->first);
+        candidates.append(candidate);
+    }
+    return candidates;
+}
+
+int PhoneIndex::size() const {
+    return int(customers.size());
+}
+
+QString PhoneIndex::normalize(const QString &phone) {
+    QString digits;
+    digits.reserve(phone.size());
+    for (const QChar c : phone) {
+        if (c.unicode() >= '0' && c.unicode() <= '9') {
+            digits.append(c);
+        } else if (c.unicode() >= 0xFF10 && c.unicode() <= 0xFF19) {
+            digits.append(QChar(u'0' + (c.unicode() - 0xFF10)));
+        }
+    }
+    return digits;
+}
+
+int PhoneIndex::customerFor(const QString &phone) {
+    const QString digits = normalize(phone);
+    if (digits.isEmpty()) {
+        return -1;
+    }
+    const auto found = byDigits.constFind(digits);
+    if (found != byDigits.constEnd()) {
+        return found.value();
+    }
+
+    Customer customer;
+    customer.phone = phone.trimmed();
+    customer.digits = digits;
+    customer.reversed = reversedText(digits);
+    customer.lastServiceDay = std::numeric_limits<qint64>::min();
+    customer.lastCreatedMs = std::numeric_limits<qint64>::min();
+    const int index = int(customers.size());
+    customers.append(customer);
+    byDigits.insert(digits, index);
+
+    // New customers are sorted in on the next lookup, so loading many of them costs one sort, not one shift each.
+    prefixOrder.append(index);
+    suffixOrder.append(index);
+    return index;
+}
+
+void PhoneIndex::sortPending() const {
+    if (sortedCount == prefixOrder.size()) {
+        return;
+    }
+    const auto byPrefix = [this](int a, int b) { return customers.at(a).digits < customers.at(b).digits; };
+    const auto bySuffix = [this](int a, int b) { return customers.at(a).reversed < customers.at(b).reversed; };
+    std::sort(prefixOrder.begin() + sortedCount, prefixOrder.end(), byPrefix);
+    std::inplace_merge(prefixOrder.begin(), prefixOrder.begin() + sortedCount, prefixOrder.end(), byPrefix);
+    std::sort(suffixOrder.begin() + sortedCount, suffixOrder.end(), bySuffix);
+    std::inplace_merge(suffixOrder.begin(), suffixOrder.begin() + sortedCount, suffixOrder.end(), bySuffix);
+    sortedCount = prefixOrder.size();
+}
+
+void PhoneIndex::absorb(Customer &customer, const Records::ServiceRecord &record) {
+    ++customer.records;
+    const bool newer = record.serviceDay > customer.lastServiceDay
+        || (record.serviceDay == customer.lastServiceDay && record.createdMs > customer.lastCreatedMs);
+    if (newer || customer.customerName.isEmpty()) {
+        customer.customerName = record.customerName;
+        customer.address = record.address;
+    }
+    if (newer) {
+        customer.lastServiceDay = record.serviceDay;
+        customer.lastCreatedMs = record.createdMs;
+    }
+}
+
+void PhoneIndex::collect(const QVector<int> &order, bool reversed, const QString &key, QVector<int> *matches) const {
+    const auto keyOf = [this, reversed](int index) -> const QString & {
+        return reversed ? customers.at(index).reversed : customers.at(index).digits;
+    };
+    auto it = std::lower_bound(order.cbegin(), order.cend(), key, [&keyOf](int index, const QString &value) {
+        return keyOf(index) < value;
+    });
+    for (; it != order.cend() && keyOf(*it).startsWith(key); ++it) {
+        matches->append(*it);
+    }
+}
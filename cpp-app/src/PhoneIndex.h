@@ -0,0 +1,55 @@
+#pragma once
+
+#include <QHash>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+#include "Records.h"
+
+class PhoneIndex {
+public:
+    enum Match { ExactMatch, PrefixMatch, SuffixMatch };
+
+    struct Candidate {
+        QString phone;
+        QString customerName;
+        QString address;
+        qint64 lastServiceDay = 0;
+        int records = 0;
+        Match match = ExactMatch;
+    };
+
+    void setCustomer(const QString &phone, const QVector<Records::ServiceRecord> &records);
+    void addRecord(const Records::ServiceRecord &record);
+    void clear();
+
+    QVector<Candidate> lookup(const QString &text, int limit) const;
+    int size() const;
+
+    static QString normalize(const QString &phone);
+
+private:
+    struct Customer {
+        QString phone;
+        QString digits;
+        QString reversed;
+        QString customerName;
+        QString address;
+        qint64 lastServiceDay = 0;
+        qint64 lastCreatedMs = 0;
+        int records = 0;
+    };
+
+    int customerFor(const QString &phone);
+    void absorb(Customer &customer, const Records::ServiceRecord &record);
+    void sortPending() const;
+    void collect(const QVector<int> &order, bool reversed, const QString &key, QVector<int> *matches) const;
+
+    QVector<Customer> customers;
+    QHash<QString, int> byDigits;
+    // Indexes of customers sorted by digits and by reversed digits; entries past sortedCount are not sorted yet.
+    mutable QVector<int> prefixOrder;
+    mutable QVector<int> suffixOrder;
+    mutable qsizetype sortedCount = 0;
+};
@@ -0,0 +1,224 @@
+#include "RecordCache.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
+
+namespace {
+const char *kIndexFileName = "index.json";
+// The index is rewritten at most this often; entries stored since the last write are swept as orphans after a crash.
+const qint64 kIndexSaveIntervalMs = 5000;
+} // namespace
+
+RecordCache::RecordCache(const QString &directory, qint64 maxBytes) : directory(directory), byteLimit(maxBytes) {
+    if (this->directory.isEmpty()) {
+        this->directory = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/record-cache";
+    }
+    QDir().mkpath(this->directory);
+    loadIndex();
+}
+
+RecordCache::~RecordCache() {
+    saveIndex();
+}
+
+QString RecordCache::filePath(const QString &fileName) const {
+    return directory + '/' + fileName;
+}
+
+QString RecordCache::fileNameForKey(const QString &key) const {
+    const QByteArray digest = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1);
+    return QString::fromLatin1(digest.toHex()) + ".json";
+}
+
+bool RecordCache::locate(const QString &key, QString *path, QDateTime *fetchedAt) {
+    auto it = index.find(key);
+    if (it == index.end()) {
+        ++counters.misses;
+        return false;
+    }
+    it->lastAccess = QDateTime::currentMSecsSinceEpoch();
+    indexDirty = true;
+    ++counters.hits;
+    *path = filePath(it->fileName);
+    *fetchedAt = it->fetchedAt;
+    return true;
+}
+
+bool RecordCache::readRows(const QString &path, QJsonArray *rows) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+    if (!doc.isObject()) {
+        return false;
+    }
+    *rows = doc.object().value("rows").toArray();
+    return true;
+}
+
+QList<QPair<QString, QString>> RecordCache::files() const {
+    QList<QPair<QString, QString>> result;
+    result.reserve(index.size());
+    for (auto it = index.cbegin(); it != index.cend(); ++it) {
+        result.append({it.key(), filePath(it->fileName)});
+    }
+    return result;
+}
+
+void RecordCache::store(const QString &key, const QJsonArray &rows) {
+    writeBytes(key, encode(key, rows), QDateTime::currentDateTime());
+}
+
+void RecordCache::appendRow(const QString &key, const QJsonObject &row) {
+    auto it = index.find(key);
+    if (it == index.end()) {
+        return;
+    }
+    QJsonArray rows;
+    if (!readRows(filePath(it->fileName), &rows)) {
+        remove(key);
+        return;
+    }
+    rows.append(row);
+    writeBytes(key, encode(key, rows), it->fetchedAt);
+}
+
+void RecordCache::remove(const QString &key) {
+    auto it = index.find(key);
+    if (it == index.end()) {
+        return;
+    }
+    QFile::remove(filePath(it->fileName));
+    totalBytes -= it->bytes;
+    index.erase(it);
+    indexDirty = true;
+    saveIndexSoon();
+}
+
+RecordCache::Stats RecordCache::stats() const {
+    Stats result = counters;
+    result.bytes = totalBytes;
+    result.entries = index.size();
+    return result;
+}
+
+qint64 RecordCache::maxBytes() const {
+    return byteLimit;
+}
+
+QByteArray RecordCache::encode(const QString &key, const QJsonArray &rows) {
+    QJsonObject obj;
+    obj.insert("key", key);
+    obj.insert("rows", rows);
+    return QJsonDocument(obj).toJson(QJsonDocument::Compact);
+}
+
+void RecordCache::storeEncoded(const QString &key, const QByteArray &bytes) {
+    writeBytes(key, bytes, QDateTime::currentDateTime());
+}
+
+void RecordCache::writeBytes(const QString &key, const QByteArray &bytes, const QDateTime &fetchedAt) {
+    Meta meta = index.value(key);
+    if (meta.fileName.isEmpty()) {
+        meta.fileName = fileNameForKey(key);
+    }
+
+    QSaveFile file(filePath(meta.fileName));
+    if (!file.open(QIODevice::WriteOnly) || file.write(bytes) != bytes.size() || !file.commit()) {
+        return;
+    }
+
+    totalBytes += bytes.size() - meta.bytes;
+    meta.bytes = bytes.size();
+    meta.lastAccess = QDateTime::currentMSecsSinceEpoch();
+    meta.fetchedAt = fetchedAt;
+    index.insert(key, meta);
+    indexDirty = true;
+
+    evictToFit();
+    saveIndexSoon();
+}
+
+void RecordCache::evictToFit() {
+    while (totalBytes > byteLimit && index.size() > 1) {
+        auto oldest = index.end();
+        for (auto it = index.begin(); it != index.end(); ++it) {
+            if (oldest == index.end() || it->lastAccess < oldest->lastAccess) {
+                oldest = it;
+            }
+        }
+        QFile::remove(filePath(oldest->fileName));
+        totalBytes -= oldest->bytes;
+        index.erase(oldest);
+        ++counters.evictions;
+        indexDirty = true;
+    }
+}
+
+void RecordCache::loadIndex() {
+    QFile file(filePath(kIndexFileName));
+    const QJsonObject root = file.open(QIODevice::ReadOnly) ? QJsonDocument::fromJson(file.readAll()).object() : QJsonObject();
+    for (auto it = root.begin(); it != root.end(); ++it) {
+        const QJsonObject obj = it.value().toObject();
+        Meta meta;
+        meta.fileName = obj.value("file").toString();
+        meta.lastAccess = obj.value("last_access").toInteger();
+        meta.fetchedAt = QDateTime::fromMSecsSinceEpoch(obj.value("fetched_at").toInteger());
+        // The file may have been rewritten after the index was last saved, so its size is taken from disk.
+        const QFileInfo info(filePath(meta.fileName));
+        if (meta.fileName.isEmpty() || !info.exists()) {
+            continue;
+        }
+        meta.bytes = info.size();
+        index.insert(it.key(), meta);
+        totalBytes += meta.bytes;
+    }
+
+    // Files stored after the last index save are not in it; they would never be evicted.
+    QSet<QString> known;
+    for (const auto &meta : std::as_const(index)) {
+        known.insert(meta.fileName);
+    }
+    for (const auto &name : QDir(directory).entryList({"*.json"}, QDir::Files)) {
+        if (name != QLatin1String(kIndexFileName) && !known.contains(name)) {
+            QFile::remove(filePath(name));
+        }
+    }
+    evictToFit();
+}
+
+void RecordCache::saveIndexSoon() {
+    if (!lastIndexSave.isValid() || lastIndexSave.elapsed() >= kIndexSaveIntervalMs) {
+        saveIndex();
+    }
+}
+
+void RecordCache::saveIndex() {
+    if (!indexDirty) {
+        return;
+    }
+    lastIndexSave.start();
+    QJsonObject root;
+    for (auto it = index.cbegin(); it != index.cend(); ++it) {
+        QJsonObject obj;
+        obj.insert("file", it->fileName);
+        obj.insert("bytes", it->bytes);
+        obj.insert("last_access", it->lastAccess);
+        obj.insert("fetched_at", it->fetchedAt.toMSecsSinceEpoch());
+        root.insert(it.key(), obj);
+    }
+    QSaveFile file(filePath(kIndexFileName));
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+        if (file.commit()) {
+            indexDirty = false;
+        }
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QList>
+#include <QPair>
+#include <QString>
+
+class RecordCache {
+public:
+    explicit RecordCache(const QString &directory = QString(), qint64 maxBytes = 64 * 1024 * 1024);
+    ~RecordCache();
+
+    struct Stats {
+        qint64 hits = 0;
+        qint64 misses = 0;
+        qint64 evictions = 0;
+        qint64 bytes = 0;
+        int entries = 0;
+    };
+
+    // Finds the file holding the key's rows without reading it, and counts a hit or a miss.
+    bool locate(const QString &key, QString *path, QDateTime *fetchedAt);
+    // Reads rows from a file named by locate() or files(); touches no cache state, so it is safe on any thread.
+    static bool readRows(const QString &path, QJsonArray *rows);
+    // Every key with its file, for reading on another thread.
+    QList<QPair<QString, QString>> files() const;
+    void store(const QString &key, const QJsonArray &rows);
+    // Stores bytes produced by encode(), which is safe to call off the GUI thread.
+    void storeEncoded(const QString &key, const QByteArray &bytes);
+    void appendRow(const QString &key, const QJsonObject &row);
+    void remove(const QString &key);
+
+    static QByteArray encode(const QString &key, const QJsonArray &rows);
+    Stats stats() const;
+    qint64 maxBytes() const;
+
+private:
+    struct Meta {
+        QString fileName;
+        qint64 bytes = 0;
+        qint64 lastAccess = 0;
+        QDateTime fetchedAt;
+    };
+
+    QString filePath(const QString &fileName) const;
+    QString fileNameForKey(const QString &key) const;
+    void writeBytes(const QString &key, const QByteArray &bytes, const QDateTime &fetchedAt);
+    void evictToFit();
+    void loadIndex();
+    void saveIndexSoon();
+    void saveIndex();
+
+    QString directory;
+    qint64 byteLimit = 0;
+    qint64 totalBytes = 0;
+    bool indexDirty = false;
+    QElapsedTimer lastIndexSave;
+    QHash<QString, Meta> index;
+    Stats counters;
+};
@@ -0,0 +1,336 @@
+#include "RecordColumns.h"
+
+#include <cstring>
+#include <limits>
+#include <numeric>
+
+#include "DateUtils.h"
+
+namespace {
+const qint32 kNoDay = std::numeric_limits<qint32>::min();
+const quint8 kIrregularCycle = 0xff;
+// Rough cost of one QHash node plus its share of the bucket array.
+const qint64 kHashEntryBytes = 32;
+
+template <typename T>
+qint64 vectorBytes(const QVector<T> &values) {
+    return qint64(values.capacity()) * qint64(sizeof(T));
+}
+
+qint64 stringHeapBytes(const QString &text) {
+    // Header, UTF-16 payload with terminator, and allocator rounding.
+    return text.isEmpty() ? 0 : 32 + qint64(text.size()) * 2;
+}
+
+QString maskText(quint8 mask, const QStringList &vocabulary) {
+    QStringList values;
+    for (int i = 0; i < vocabulary.size(); ++i) {
+        if (mask & (1 << i)) {
+            values.append(vocabulary.at(i));
+        }
+    }
+    return Records::joinList(values);
+}
+
+qint32 toDay(const QDate &date) {
+    if (!date.isValid()) {
+        return kNoDay;
+    }
+    const qint64 day = date.toJulianDay();
+    return day > kNoDay && day <= std::numeric_limits<qint32>::max() ? qint32(day) : kNoDay;
+}
+
+QDate fromDay(qint32 day) {
+    return day == kNoDay ? QDate() : QDate::fromJulianDay(day);
+}
+} // namespace
+
+RecordColumns::StringPool::StringPool() {
+    clear();
+}
+
+quint32 RecordColumns::StringPool::intern(const QString &text) {
+    if (text.isEmpty()) {
+        return 0;
+    }
+    const QByteArray utf8 = text.toUtf8();
+    const size_t hash = qHash(utf8);
+    const auto range = byHash.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        const quint32 begin = offsets.at(it.value());
+        const quint32 length = offsets.at(it.value() + 1) - begin;
+        if (length == quint32(utf8.size()) && std::memcmp(arena.constData() + begin, utf8.constData(), length) == 0) {
+            return it.value();
+        }
+    }
+    const quint32 id = quint32(offsets.size() - 1);
+    arena.append(utf8);
+    offsets.append(quint32(arena.size()));
+    byHash.insert(hash, id);
+    return id;
+}
+
+QString RecordColumns::StringPool::at(quint32 id) const {
+    const quint32 begin = offsets.at(id);
+    return QString::fromUtf8(arena.constData() + begin, offsets.at(id + 1) - begin);
+}
+
+void RecordColumns::StringPool::clear() {
+    arena.clear();
+    offsets = {0, 0};
+    byHash.clear();
+}
+
+int RecordColumns::StringPool::size() const {
+    return int(offsets.size() - 1);
+}
+
+qint64 RecordColumns::StringPool::bytes() const {
+    return arena.size();
+}
+
+qint64 RecordColumns::StringPool::approxBytes() const {
+    return arena.capacity() + vectorBytes(offsets) + byHash.size() * kHashEntryBytes;
+}
+
+int RecordColumns::append(const Records::ServiceRecord &record, const QString &searchText) {
+    const int row = size();
+
+    auto customer = customerByPhone.constFind(record.phone);
+    if (customer == customerByPhone.cend()) {
+        customers.append({record.phone, strings.intern(record.customerName), strings.intern(record.address)});
+        customer = customerByPhone.insert(record.phone, quint32(customers.size() - 1));
+    }
+    // The first record of a phone sets the customer's name and address; later records only store a difference.
+    const Customer &entry = customers.at(customer.value());
+    keepIfDifferent(row, NameField, record.customerName, strings.at(entry.name));
+    keepIfDifferent(row, AddressField, record.address, strings.at(entry.address));
+    customerIds.append(customer.value());
+
+    const qint32 day = toDay(record.serviceDate);
+    keepIfDifferent(row, ServiceDateField, record.serviceDateRoc, day == kNoDay ? QString() : DateUtils::dateToRoc(fromDay(day)));
+    serviceDays.append(day);
+    createdTimes.append(record.createdMs);
+    nextReplaceDays.append(encodeRocDay(row, NextReplaceField, record.nextReplaceRoc));
+    warrantyEndDays.append(encodeRocDay(row, WarrantyEndField, record.warrantyEndRoc));
+    otherItemIds.append(strings.intern(record.otherItemText));
+    noteIds.append(strings.intern(record.notes));
+    searchTextIds.append(strings.intern(searchText));
+
+    itemMasks.append(record.itemMask);
+    purposeMasks.append(record.purposeMask);
+    keepIfDifferent(row, ItemsField, record.itemsText, maskText(record.itemMask, Records::kItems));
+    keepIfDifferent(row, PurposesField, record.purposesText, maskText(record.purposeMask, Records::kPurposes));
+
+    quint8 cycle = 0;
+    if (!record.waterCycle.isEmpty()) {
+        const int index = Records::kWaterCycles.indexOf(record.waterCycle);
+        cycle = index >= 0 ? quint8(index + 1) : kIrregularCycle;
+    }
+    if (cycle == kIrregularCycle) {
+        irregular.insert(irregularKey(row, CycleField), strings.intern(record.waterCycle));
+    }
+    cycleCodes.append(cycle);
+    return row;
+}
+
+void RecordColumns::reserve(int records) {
+    customerIds.reserve(records);
+    serviceDays.reserve(records);
+    createdTimes.reserve(records);
+    nextReplaceDays.reserve(records);
+    warrantyEndDays.reserve(records);
+    otherItemIds.reserve(records);
+    noteIds.reserve(records);
+    searchTextIds.reserve(records);
+    itemMasks.reserve(records);
+    purposeMasks.reserve(records);
+    cycleCodes.reserve(records);
+}
+
+void RecordColumns::clear() {
+    strings.clear();
+    customers.clear();
+    customerByPhone.clear();
+    customerIds.clear();
+    serviceDays.clear();
+    createdTimes.clear();
+    nextReplaceDays.clear();
+    warrantyEndDays.clear();
+    otherItemIds.clear();
+    noteIds.clear();
+    searchTextIds.clear();
+    itemMasks.clear();
+    purposeMasks.clear();
+    cycleCodes.clear();
+    irregular.clear();
+}
+
+int RecordColumns::size() const {
+    return int(customerIds.size());
+}
+
+Records::ServiceRecord RecordColumns::record(int row) const {
+    Records::ServiceRecord record;
+    record.serviceDate = fromDay(serviceDays.at(row));
+    record.serviceDay = record.serviceDate.toJulianDay();
+    record.createdMs = createdTimes.at(row);
+    if (record.createdMs != std::numeric_limits<qint64>::min()) {
+        record.createdAt = QDateTime::fromMSecsSinceEpoch(record.createdMs);
+    }
+    record.serviceDateRoc = serviceDateRoc(row);
+    record.customerName = customerName(row);
+    record.phone = phone(row);
+    record.address = address(row);
+    record.itemMask = itemMasks.at(row);
+    record.purposeMask = purposeMasks.at(row);
+    if (!irregularText(row, ItemsField, &record.itemsText)) {
+        record.itemsText = maskText(record.itemMask, Records::kItems);
+    }
+    if (!irregularText(row, PurposesField, &record.purposesText)) {
+        record.purposesText = maskText(record.purposeMask, Records::kPurposes);
+    }
+    record.otherItemText = otherItemText(row);
+    const quint8 cycle = cycleCodes.at(row);
+    if (cycle == kIrregularCycle) {
+        irregularText(row, CycleField, &record.waterCycle);
+    } else if (cycle > 0) {
+        record.waterCycle = Records::kWaterCycles.at(cycle - 1);
+    }
+    record.nextReplaceRoc = decodeRocDay(row, NextReplaceField, nextReplaceDays.at(row));
+    record.warrantyEndRoc = decodeRocDay(row, WarrantyEndField, warrantyEndDays.at(row));
+    record.notes = notes(row);
+    return record;
+}
+
+QString RecordColumns::phone(int row) const {
+    return customers.at(customerIds.at(row)).phone;
+}
+
+QString RecordColumns::customerName(int row) const {
+    QString text;
+    return irregularText(row, NameField, &text) ? text : strings.at(customers.at(customerIds.at(row)).name);
+}
+
+QString RecordColumns::address(int row) const {
+    QString text;
+    return irregularText(row, AddressField, &text) ? text : strings.at(customers.at(customerIds.at(row)).address);
+}
+
+QString RecordColumns::serviceDateRoc(int row) const {
+    return decodeRocDay(row, ServiceDateField, serviceDays.at(row));
+}
+
+QString RecordColumns::otherItemText(int row) const {
+    return strings.at(otherItemIds.at(row));
+}
+
+QString RecordColumns::notes(int row) const {
+    return strings.at(noteIds.at(row));
+}
+
+QString RecordColumns::searchText(int row) const {
+    return strings.at(searchTextIds.at(row));
+}
+
+qint64 RecordColumns::serviceDay(int row) const {
+    const qint32 day = serviceDays.at(row);
+    return day == kNoDay ? QDate().toJulianDay() : day;
+}
+
+qint64 RecordColumns::createdMs(int row) const {
+    return createdTimes.at(row);
+}
+
+quint8 RecordColumns::itemMask(int row) const {
+    return itemMasks.at(row);
+}
+
+QVector<int> RecordColumns::rowsWithItems(quint8 mask) const {
+    QVector<int> rows;
+    const quint8 *masks = itemMasks.constData();
+    const int count = itemMasks.size();
+    for (int row = 0; row < count; ++row) {
+        if (masks[row] & mask) {
+            rows.append(row);
+        }
+    }
+    return rows;
+}
+
+QVector<int> RecordColumns::rowsMatching(bool onlyWater) const {
+    if (onlyWater) {
+        return rowsWithItems(Records::WaterItem);
+    }
+    QVector<int> rows(size());
+    std::iota(rows.begin(), rows.end(), 0);
+    return rows;
+}
+
+RecordColumns::Stats RecordColumns::stats() const {
+    Stats stats;
+    stats.records = size();
+    stats.customers = int(customers.size());
+    stats.strings = strings.size();
+    stats.stringBytes = strings.bytes();
+    stats.irregular = int(irregular.size());
+
+    qint64 bytes = strings.approxBytes() + vectorBytes(customers) + customerByPhone.size() * kHashEntryBytes;
+    for (const auto &customer : customers) {
+        bytes += stringHeapBytes(customer.phone);
+    }
+    bytes += vectorBytes(customerIds) + vectorBytes(serviceDays) + vectorBytes(createdTimes) + vectorBytes(nextReplaceDays) +
+             vectorBytes(warrantyEndDays) + vectorBytes(otherItemIds) + vectorBytes(noteIds) + vectorBytes(searchTextIds) + vectorBytes(itemMasks) +
+             vectorBytes(purposeMasks) + vectorBytes(cycleCodes) + irregular.size() * kHashEntryBytes;
+    stats.approxBytes = bytes;
+    return stats;
+}
+
+qint64 RecordColumns::approxRecordBytes(const Records::ServiceRecord &record) {
+    qint64 bytes = sizeof(Records::ServiceRecord);
+    for (const QString *text : {&record.serviceDateRoc, &record.customerName, &record.phone, &record.address,
+                                &record.itemsText, &record.purposesText, &record.otherItemText, &record.waterCycle,
+                                &record.nextReplaceRoc, &record.warrantyEndRoc, &record.notes}) {
+        bytes += stringHeapBytes(*text);
+    }
+    return bytes;
+}
+
+quint64 RecordColumns::irregularKey(int row, Field field) {
+    return (quint64(row) << 4) | field;
+}
+
+qint32 RecordColumns::encodeRocDay(int row, Field field, const QString &text) {
+    if (text.isEmpty()) {
+        return kNoDay;
+    }
+    const qint32 day = toDay(DateUtils::rocToAdDate(text));
+    keepIfDifferent(row, field, text, day == kNoDay ? QString() : DateUtils::dateToRoc(fromDay(day)));
+    return day;
+}
+
+QString RecordColumns::decodeRocDay(int row, Field field, qint32 day) const {
+    QString text;
+    if (irregularText(row, field, &text)) {
+        return text;
+    }
+    return day == kNoDay ? QString() : DateUtils::dateToRoc(fromDay(day));
+}
+
+void RecordColumns::keepIfDifferent(int row, Field field, const QString &text, const QString &decoded) {
+    if (text != decoded) {
+        irregular.insert(irregularKey(row, field), strings.intern(text));
+    }
+}
+
+bool RecordColumns::irregularText(int row, Field field, QString *text) const {
+    if (irregular.isEmpty()) {
+        return false;
+    }
+    const auto it = irregular.constFind(irregularKey(row, field));
+    if (it == irregular.cend()) {
+        return false;
+    }
+    *text = strings.at(it.value());
+    return true;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+#include "Records.h"
+
+// Records kept column by column: item/purpose bitmasks, cycle codes, dates as day numbers and pooled strings,
+// with one customer entry per phone. Values that the encodings cannot reproduce exactly are kept verbatim on the side.
+class RecordColumns {
+public:
+    struct Stats {
+        qint64 records = 0;
+        int customers = 0;
+        int strings = 0;
+        qint64 stringBytes = 0;
+        int irregular = 0;
+        qint64 approxBytes = 0;
+    };
+
+    // searchText is kept with the row for the caller to match against, pooled like the other text.
+    int append(const Records::ServiceRecord &record, const QString &searchText = QString());
+    void reserve(int records);
+    void clear();
+    int size() const;
+
+    Records::ServiceRecord record(int row) const;
+    QString phone(int row) const;
+    QString customerName(int row) const;
+    QString address(int row) const;
+    QString serviceDateRoc(int row) const;
+    QString otherItemText(int row) const;
+    QString notes(int row) const;
+    QString searchText(int row) const;
+    qint64 serviceDay(int row) const;
+    qint64 createdMs(int row) const;
+    quint8 itemMask(int row) const;
+
+    // Rows that have any of the given item bits, in insertion order.
+    QVector<int> rowsWithItems(quint8 mask) const;
+    QVector<int> rowsMatching(bool onlyWater) const;
+
+    Stats stats() const;
+
+    // What a decoded ServiceRecord costs on the heap, for comparison with stats().approxBytes.
+    static qint64 approxRecordBytes(const Records::ServiceRecord &record);
+
+private:
+    class StringPool {
+    public:
+        StringPool();
+        quint32 intern(const QString &text);
+        QString at(quint32 id) const;
+        void clear();
+        int size() const;
+        qint64 bytes() const;
+        qint64 approxBytes() const;
+
+    private:
+        QByteArray arena;
+        // String i is arena[offsets[i], offsets[i + 1]); id 0 is the empty string.
+        QVector<quint32> offsets;
+        QMultiHash<size_t, quint32> byHash;
+    };
+
+    enum Field : quint8 {
+        NameField,
+        AddressField,
+        ServiceDateField,
+        NextReplaceField,
+        WarrantyEndField,
+        ItemsField,
+        PurposesField,
+        CycleField
+    };
+
+    struct Customer {
+        QString phone;
+        quint32 name = 0;
+        quint32 address = 0;
+    };
+
+    static quint64 irregularKey(int row, Field field);
+    qint32 encodeRocDay(int row, Field field, const QString &text);
+    QString decodeRocDay(int row, Field field, qint32 day) const;
+    void keepIfDifferent(int row, Field field, const QString &text, const QString &decoded);
+    bool irregularText(int row, Field field, QString *text) const;
+
+    StringPool strings;
+    QVector<Customer> customers;
+    QHash<QString, quint32> customerByPhone;
+
+    QVector<quint32> customerIds;
+    QVector<qint32> serviceDays;
+    QVector<qint64> createdTimes;
+    QVector<qint32> nextReplaceDays;
+    QVector<qint32> warrantyEndDays;
+    QVector<quint32> otherItemIds;
+    QVector<quint32> noteIds;
+    QVector<quint32> searchTextIds;
+    QVector<quint8> itemMasks;
+    QVector<quint8> purposeMasks;
+    QVector<quint8> cycleCodes;
+    QHash<quint64, quint32> irregular;
+};
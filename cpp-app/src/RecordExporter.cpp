@@ -0,0 +1,371 @@
+#include "RecordExporter.h"
+
+#include <QDateTime>
+#include <QList>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <limits>
+
+#include "Compression.h"
+
+namespace {
+const qsizetype kFlushBytes = 64 * 1024;
+const int kProgressRows = 1000;
+const int kMaxCellChars = 32767;
+
+void appendLe16(QByteArray &out, quint16 value) {
+    const quint16 le = qToLittleEndian(value);
+    out.append(reinterpret_cast<const char *>(&le), sizeof(le));
+}
+
+void appendLe32(QByteArray &out, quint32 value) {
+    const quint32 le = qToLittleEndian(value);
+    out.append(reinterpret_cast<const char *>(&le), sizeof(le));
+}
+
+class ChunkedOutput {
+public:
+    explicit ChunkedOutput(QIODevice *device) : device(device) {}
+
+    void write(QByteArrayView data) {
+        buffer.append(data);
+        if (buffer.size() >= kFlushBytes) {
+            flush();
+        }
+    }
+
+    void flush() {
+        if (!buffer.isEmpty() && device->write(buffer) != buffer.size()) {
+            failed = true;
+        }
+        written += buffer.size();
+        buffer.clear();
+    }
+
+    qint64 position() const {
+        return written + buffer.size();
+    }
+
+    bool ok() const {
+        return !failed;
+    }
+
+private:
+    QIODevice *device;
+    QByteArray buffer;
+    qint64 written = 0;
+    bool failed = false;
+};
+
+// Writes a zip with stored (uncompressed) entries. Sizes and CRCs follow each entry in a data descriptor,
+// so nothing has to be buffered or rewound.
+class StoredZip {
+public:
+    explicit StoredZip(ChunkedOutput &out) : out(out) {
+        const QDateTime now = QDateTime::currentDateTime();
+        const QDate date = now.date();
+        const QTime time = now.time();
+        dosDate = quint16(((date.year() - 1980) << 9) | (date.month() << 5) | date.day());
+        dosTime = quint16((time.hour() << 11) | (time.minute() << 5) | (time.second() / 2));
+    }
+
+    void beginEntry(const QByteArray &name) {
+        current = Entry{name, 0, 0, out.position()};
+        QByteArray header;
+        appendLe32(header, 0x04034b50);
+        appendHeaderFields(header, current, true);
+        header.append(name);
+        out.write(header);
+    }
+
+    void write(QByteArrayView data) {
+        current.crc = Compression::crc32(data, current.crc);
+        current.size += data.size();
+        out.write(data);
+    }
+
+    void endEntry() {
+        QByteArray descriptor;
+        appendLe32(descriptor, 0x08074b50);
+        appendLe32(descriptor, current.crc);
+        appendLe32(descriptor, quint32(current.size));
+        appendLe32(descriptor, quint32(current.size));
+        out.write(descriptor);
+        entries.append(current);
+    }
+
+    bool finish() {
+        const qint64 directoryOffset = out.position();
+        for (const auto &entry : std::as_const(entries)) {
+            QByteArray record;
+            appendLe32(record, 0x02014b50);
+            appendLe16(record, 20);
+            appendHeaderFields(record, entry, false);
+            appendLe16(record, 0);
+            appendLe16(record, 0);
+            appendLe16(record, 0);
+            appendLe32(record, 0);
+            appendLe32(record, quint32(entry.offset));
+            record.append(entry.name);
+            out.write(record);
+        }
+        const qint64 directorySize = out.position() - directoryOffset;
+
+        QByteArray end;
+        appendLe32(end, 0x06054b50);
+        appendLe16(end, 0);
+        appendLe16(end, 0);
+        appendLe16(end, quint16(entries.size()));
+        appendLe16(end, quint16(entries.size()));
+        appendLe32(end, quint32(directorySize));
+        appendLe32(end, quint32(directoryOffset));
+        appendLe16(end, 0);
+        out.write(end);
+        out.flush();
+
+        // No Zip64 support: every size and offset has to fit in 32 bits.
+        return out.ok() && out.position() < std::numeric_limits<quint32>::max();
+    }
+
+private:
+    struct Entry {
+        QByteArray name;
+        quint32 crc = 0;
+        qint64 size = 0;
+        qint64 offset = 0;
+    };
+
+    void appendHeaderFields(QByteArray &header, const Entry &entry, bool local) const {
+        appendLe16(header, 20);
+        appendLe16(header, 0x0808);
+        appendLe16(header, 0);
+        appendLe16(header, dosTime);
+        appendLe16(header, dosDate);
+        appendLe32(header, local ? 0 : entry.crc);
+        appendLe32(header, local ? 0 : quint32(entry.size));
+        appendLe32(header, local ? 0 : quint32(entry.size));
+        appendLe16(header, quint16(entry.name.size()));
+        appendLe16(header, 0);
+    }
+
+    ChunkedOutput &out;
+    QList<Entry> entries;
+    Entry current;
+    quint16 dosDate = 0;
+    quint16 dosTime = 0;
+};
+
+QByteArray csvCell(const QString &text) {
+    if (!text.contains(QLatin1Char(',')) && !text.contains(QLatin1Char('"')) && !text.contains(QLatin1Char('\n'))
+        && !text.contains(QLatin1Char('\r'))) {
+        return text.toUtf8();
+    }
+    QString quoted = text;
+    quoted.replace(QLatin1Char('"'), QStringLiteral("\"\""));
+    return '"' + quoted.toUtf8() + '"';
+}
+
+QByteArray csvRow(const QStringList &cells) {
+    QByteArray line;
+    for (int i = 0; i < cells.size(); ++i) {
+        if (i > 0) {
+            line.append(',');
+        }
+        line.append(csvCell(cells.at(i)));
+    }
+    line.append("\r\n");
+    return line;
+}
+
+QByteArray xlsxRow(const QStringList &cells) {
+    QString xml = QStringLiteral("<row>");
+    for (const auto &cell : cells) {
+        if (cell.isEmpty()) {
+            xml += QStringLiteral("<c/>");
+            continue;
+        }
+        xml += QStringLiteral("<c t=\"inlineStr\"><is><t xml:space=\"preserve\">");
+        for (const QChar c : cell.left(kMaxCellChars)) {
+            const char16_t u = c.unicode();
+            if (u == '&') {
+                xml += QStringLiteral("&amp;");
+            } else if (u == '<') {
+                xml += QStringLiteral("&lt;");
+            } else if (u == '>') {
+                xml += QStringLiteral("&gt;");
+            } else if ((u >= 0x20 && u != 0xfffe && u != 0xffff) || u == '\t' || u == '\n' || u == '\r') {
+                xml += c;
+            }
+        }
+        xml += QStringLiteral("</t></is></c>");
+    }
+    xml += QStringLiteral("</row>");
+    return xml.toUtf8();
+}
+
+const char kXmlDeclaration[] = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n";
+
+const char kContentTypes[] =
+    "<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\">"
+    "<Default Extension=\"rels\" ContentType=\"application/vnd.openxmlformats-package.relationships+xml\"/>"
+    "<Default Extension=\"xml\" ContentType=\"application/xml\"/>"
+    "<Override PartName=\"/xl/workbook.xml\" "
+    "ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sheet.main+xml\"/>"
+    "<Override PartName=\"/xl/worksheets/sheet1.xml\" "
+    "ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.worksheet+xml\"/>"
+    "</Types>";
+
+const char kRootRels[] =
+    "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
+    "<Relationship Id=\"rId1\" "
+    "Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/officeDocument\" "
+    "Target=\"xl/workbook.xml\"/>"
+    "</Relationships>";
+
+const char kWorkbook[] =
+    "<workbook xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" "
+    "xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\">"
+    "<sheets><sheet name=\"紀錄\" sheetId=\"1\" r:id=\"rId1\"/></sheets>"
+    "</workbook>";
+
+const char kWorkbookRels[] =
+    "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
+    "<Relationship Id=\"rId1\" "
+    "Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/worksheet\" "
+    "Target=\"worksheets/sheet1.xml\"/>"
+    "</Relationships>";
+
+const char kSheetStart[] =
+    "<worksheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\"><sheetData>";
+const char kSheetEnd[] = "</sheetData></worksheet>";
+
+void writePart(StoredZip &zip, const char *name, const char *body) {
+    zip.beginEntry(name);
+    zip.write(kXmlDeclaration);
+    zip.write(body);
+    zip.endEntry();
+}
+} // namespace
+
+RecordExporter::RecordExporter(QObject *parent) : QObject(parent) {}
+
+RecordExporter::~RecordExporter() {
+    if (worker) {
+        cancel();
+        worker->wait();
+        delete worker;
+    }
+}
+
+bool RecordExporter::start(const QString &path, Format format, bool onlyWater, qint64 expectedRows,
+                           const RowSource &source) {
+    if (worker) {
+        return false;
+    }
+    cancelRequested = false;
+    worker = QThread::create([this, path, format, onlyWater, expectedRows, source]() {
+        outcome = run(path, format, onlyWater, expectedRows, source);
+    });
+    connect(worker, &QThread::finished, this, [this]() {
+        worker->deleteLater();
+        worker = nullptr;
+        emit finished(outcome.ok, outcome.rows, outcome.message);
+    });
+    worker->start(QThread::LowPriority);
+    return true;
+}
+
+void RecordExporter::cancel() {
+    cancelRequested = true;
+}
+
+bool RecordExporter::isRunning() const {
+    return worker != nullptr;
+}
+
+RecordExporter::Format RecordExporter::formatForPath(const QString &path) {
+    return path.endsWith(QStringLiteral(".xlsx"), Qt::CaseInsensitive) ? Xlsx : Csv;
+}
+
+bool RecordExporter::exportRows(QIODevice *device, Format format, bool onlyWater, const RowSource &source,
+                                const ProgressHandler &onProgress, qint64 *rows) {
+    ChunkedOutput out(device);
+    StoredZip zip(out);
+    qint64 count = 0;
+    bool stopped = false;
+
+    const auto visit = [&](const Records::ServiceRecord &record) {
+        const QStringList cells = Records::displayRow(record, onlyWater);
+        if (format == Xlsx) {
+            zip.write(xlsxRow(cells));
+        } else {
+            out.write(csvRow(cells));
+        }
+        ++count;
+        if (count % kProgressRows == 0 && onProgress && !onProgress(count)) {
+            stopped = true;
+        }
+        return !stopped && out.ok();
+    };
+
+    if (format == Xlsx) {
+        writePart(zip, "[Content_Types].xml", kContentTypes);
+        writePart(zip, "_rels/.rels", kRootRels);
+        writePart(zip, "xl/workbook.xml", kWorkbook);
+        writePart(zip, "xl/_rels/workbook.xml.rels", kWorkbookRels);
+        zip.beginEntry("xl/worksheets/sheet1.xml");
+        zip.write(kXmlDeclaration);
+        zip.write(kSheetStart);
+        zip.write(xlsxRow(Records::displayHeaders()));
+    } else {
+        // The BOM lets Excel open the UTF-8 file without garbling Chinese text.
+        out.write("\xEF\xBB\xBF");
+        out.write(csvRow(Records::displayHeaders()));
+    }
+
+    source(visit);
+    if (rows) {
+        *rows = count;
+    }
+    if (stopped) {
+        return false;
+    }
+
+    if (format == Xlsx) {
+        zip.write(kSheetEnd);
+        zip.endEntry();
+        return zip.finish();
+    }
+    out.flush();
+    return out.ok();
+}
+
+RecordExporter::Outcome RecordExporter::run(const QString &path, Format format, bool onlyWater, qint64 expectedRows,
+                                            const RowSource &source) {
+    Outcome result;
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        result.message = QString("無法寫入檔案：%1").arg(file.errorString());
+        return result;
+    }
+
+    const auto onProgress = [this, expectedRows](qint64 rows) {
+        emit progress(rows, expectedRows);
+        return !cancelRequested;
+    };
+    const bool written = exportRows(&file, format, onlyWater, source, onProgress, &result.rows);
+    if (cancelRequested) {
+        file.cancelWriting();
+        result.message = QStringLiteral("已取消匯出");
+        return result;
+    }
+    if (!written || !file.commit()) {
+        file.cancelWriting();
+        result.message = QString("匯出失敗：%1").arg(file.errorString());
+        return result;
+    }
+    result.ok = true;
+    emit progress(result.rows, expectedRows);
+    return result;
+}
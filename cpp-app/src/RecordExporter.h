@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QIODevice>
+#include <QObject>
+#include <QString>
+#include <QThread>
+
+#include <atomic>
+#include <functional>
+
+#include "Records.h"
+
+class RecordExporter : public QObject {
+    Q_OBJECT
+
+public:
+    enum Format { Csv, Xlsx };
+
+    using RowVisitor = std::function<bool(const Records::ServiceRecord &record)>;
+    // Called on the worker thread; must stop as soon as the visitor returns false.
+    using RowSource = std::function<void(const RowVisitor &visit)>;
+    using ProgressHandler = std::function<bool(qint64 rows)>;
+
+    explicit RecordExporter(QObject *parent = nullptr);
+    ~RecordExporter() override;
+
+    bool start(const QString &path, Format format, bool onlyWater, qint64 expectedRows, const RowSource &source);
+    void cancel();
+    bool isRunning() const;
+
+    static Format formatForPath(const QString &path);
+    static bool exportRows(QIODevice *device, Format format, bool onlyWater, const RowSource &source,
+                           const ProgressHandler &onProgress, qint64 *rows);
+
+signals:
+    void progress(qint64 rows, qint64 expectedRows);
+    void finished(bool ok, qint64 rows, const QString &message);
+
+private:
+    struct Outcome {
+        bool ok = false;
+        qint64 rows = 0;
+        QString message;
+    };
+
+    Outcome run(const QString &path, Format format, bool onlyWater, qint64 expectedRows, const RowSource &source);
+
+    QThread *worker = nullptr;
+    std::atomic_bool cancelRequested{false};
+    Outcome outcome;
+};
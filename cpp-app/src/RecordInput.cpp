@@ -0,0 +1,101 @@
+#include "RecordInput.h"
+
+#include <QDateTime>
+#include <QJsonArray>
+
+#include "DateUtils.h"
+#include "Records.h"
+
+namespace RecordInput {
+
+QString nextReplaceRoc(const QDate &serviceDate, const QStringList &items, const QString &waterCycle) {
+    if (!serviceDate.isValid() || !items.contains(Records::kWaterItem)) {
+        return {};
+    }
+    const int months = Records::cycleToMonths(waterCycle);
+    return months > 0 ? DateUtils::dateToRoc(DateUtils::addMonths(serviceDate, months)) : QString();
+}
+
+QString warrantyEndRoc(const QDate &serviceDate, const QStringList &items) {
+    if (!serviceDate.isValid() || !items.contains(Records::kGasItem)) {
+        return {};
+    }
+    return DateUtils::dateToRoc(DateUtils::addOneYear(serviceDate));
+}
+
+QJsonObject build(const Fields &fields, QString *error) {
+    const auto fail = [error](const QString &message) {
+        if (error) {
+            *error = message;
+        }
+        return QJsonObject();
+    };
+
+    const QString dateText = fields.serviceDate.trimmed();
+    if (!DateUtils::isYmd(dateText)) {
+        return fail(QStringLiteral("❌ 日期格式錯誤，請用 YYYY-MM-DD"));
+    }
+    const QDate date = DateUtils::parseYmd(dateText);
+    if (!date.isValid()) {
+        return fail(QStringLiteral("❌ 日期解析失敗，請確認 YYYY-MM-DD 是否為有效日期"));
+    }
+
+    if (fields.customerName.trimmed().isEmpty() || fields.phone.trimmed().isEmpty()) {
+        return fail(QStringLiteral("❌ 必填：姓名、電話"));
+    }
+
+    if (fields.items.contains(Records::kOtherItem) && fields.otherItemText.trimmed().isEmpty()) {
+        return fail(QStringLiteral("❌ 你有勾選「其他（自行輸入）」但未填內容"));
+    }
+
+    QString waterCycle;
+    if (fields.items.contains(Records::kWaterItem)) {
+        waterCycle = fields.waterCycle;
+        if (Records::cycleToMonths(waterCycle) <= 0) {
+            return fail(QStringLiteral("❌ 請選擇更換週期（半年/一年/一年半/兩年）"));
+        }
+    }
+
+    QJsonObject data;
+    data.insert("service_date_ad", DateUtils::dateToIso(date));
+    data.insert("service_date_roc", DateUtils::dateToRoc(date));
+    data.insert("customer_name", fields.customerName.trimmed());
+    data.insert("phone", fields.phone.trimmed());
+    data.insert("address", fields.address.trimmed());
+    data.insert("purposes", QJsonArray::fromStringList(fields.purposes));
+    data.insert("items", QJsonArray::fromStringList(fields.items));
+    data.insert("other_item_text", fields.otherItemText.trimmed());
+    data.insert("water_replace_cycle", waterCycle);
+    data.insert("next_replace_date_roc", fields.nextReplaceRoc.trimmed());
+    data.insert("warranty_end_date_roc", fields.warrantyEndRoc.trimmed());
+    data.insert("notes", fields.notes.trimmed());
+    data.insert("created_at", fields.createdAt.isEmpty() ? QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss")
+                                                          : fields.createdAt);
+    return data;
+}
+
+QJsonObject waterReplacement(const QString &phone, const QString &customerName, const QString &address,
+                             const QDate &replaceDate, const QString &waterCycle, const QString &extraNote) {
+    QString note = QStringLiteral("淨水設備更換");
+    if (!extraNote.isEmpty()) {
+        note = QString("%1｜%2").arg(note, extraNote);
+    }
+
+    QJsonObject data;
+    data.insert("service_date_ad", DateUtils::dateToIso(replaceDate));
+    data.insert("service_date_roc", DateUtils::dateToRoc(replaceDate));
+    data.insert("customer_name", customerName);
+    data.insert("phone", phone);
+    data.insert("address", address);
+    data.insert("purposes", QJsonArray{QStringLiteral("安裝")});
+    data.insert("items", QJsonArray{Records::kWaterItem});
+    data.insert("other_item_text", "");
+    data.insert("water_replace_cycle", waterCycle);
+    data.insert("next_replace_date_roc", DateUtils::dateToRoc(DateUtils::addMonths(replaceDate, Records::cycleToMonths(waterCycle))));
+    data.insert("warranty_end_date_roc", "");
+    data.insert("notes", note);
+    data.insert("created_at", QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss"));
+    return data;
+}
+
+} // namespace RecordInput
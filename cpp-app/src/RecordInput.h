@@ -0,0 +1,33 @@
+#pragma once
+
+#include <QDate>
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+
+namespace RecordInput {
+struct Fields {
+    QString serviceDate;
+    QString customerName;
+    QString phone;
+    QString address;
+    QStringList purposes;
+    QStringList items;
+    QString otherItemText;
+    QString waterCycle;
+    QString nextReplaceRoc;
+    QString warrantyEndRoc;
+    QString notes;
+    QString createdAt;
+};
+
+QString nextReplaceRoc(const QDate &serviceDate, const QStringList &items, const QString &waterCycle);
+QString warrantyEndRoc(const QDate &serviceDate, const QStringList &items);
+
+// Applies the add-record form's rules; returns an empty object and sets *error when a rule fails.
+QJsonObject build(const Fields &fields, QString *error);
+
+// The record the replacement tab posts when a customer's water filter has been changed.
+QJsonObject waterReplacement(const QString &phone, const QString &customerName, const QString &address,
+                             const QDate &replaceDate, const QString &waterCycle, const QString &extraNote);
+} // namespace RecordInput
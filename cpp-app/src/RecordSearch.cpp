@@ -0,0 +1,90 @@
+#include "RecordSearch.h"
+
+#include <QRegularExpression>
+
+#include <algorithm>
+
+namespace {
+size_t recordKey(const Records::ServiceRecord &record) {
+    return qHashMulti(0, record.phone, record.createdMs, record.serviceDateRoc, record.notes);
+}
+} // namespace
+
+bool RecordSearch::add(const Records::ServiceRecord &record) {
+    const size_t key = recordKey(record);
+    const auto range = keys.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it) {
+        const int row = it.value();
+        if (records.createdMs(row) == record.createdMs && records.phone(row) == record.phone &&
+            records.serviceDateRoc(row) == record.serviceDateRoc && records.notes(row) == record.notes) {
+            return false;
+        }
+    }
+    // Water status ranks are per customer and mean nothing in a mixed result list, so the columns do not keep them.
+    // The folded text is kept so that confirming a hit does not normalize every candidate again on each keystroke.
+    const QString text = documentText(record);
+    keys.insert(key, records.append(record, TextIndex::fold(text)));
+    index.addDocument(text);
+    return true;
+}
+
+void RecordSearch::clear() {
+    records.clear();
+    keys.clear();
+    index.clear();
+}
+
+QVector<Records::ServiceRecord> RecordSearch::search(const QString &query, int limit, int *total) const {
+    static const QRegularExpression separators(QStringLiteral("[\\s+]+"));
+    QStringList segments;
+    for (const auto &segment : query.split(separators, Qt::SkipEmptyParts)) {
+        segments.append(TextIndex::fold(segment));
+    }
+
+    // Bigram hits are only candidates: "信義 義路" shares both bigrams of "信義路" without containing it.
+    QVector<int> matches;
+    for (quint32 id : index.search(segments.join(' '))) {
+        const QString text = records.searchText(int(id));
+        const bool all = std::all_of(segments.cbegin(), segments.cend(), [&text](const QString &segment) {
+            return text.contains(segment);
+        });
+        if (all) {
+            matches.append(int(id));
+        }
+    }
+    if (total) {
+        *total = matches.size();
+    }
+
+    const auto newer = [this](int a, int b) {
+        if (records.serviceDay(a) != records.serviceDay(b)) {
+            return records.serviceDay(a) > records.serviceDay(b);
+        }
+        return records.createdMs(a) > records.createdMs(b);
+    };
+    const int count = std::clamp(limit, 0, int(matches.size()));
+    std::partial_sort(matches.begin(), matches.begin() + count, matches.end(), newer);
+
+    QVector<Records::ServiceRecord> result;
+    result.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        result.append(records.record(matches.at(i)));
+    }
+    return result;
+}
+
+int RecordSearch::size() const {
+    return records.size();
+}
+
+TextIndex::Stats RecordSearch::indexStats() const {
+    return index.stats();
+}
+
+RecordColumns::Stats RecordSearch::columnStats() const {
+    return records.stats();
+}
+
+QString RecordSearch::documentText(const Records::ServiceRecord &record) {
+    return QStringList{record.notes, record.address, record.otherItemText}.join('\n');
+}
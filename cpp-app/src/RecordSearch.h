@@ -0,0 +1,28 @@
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+#include "RecordColumns.h"
+#include "Records.h"
+#include "TextIndex.h"
+
+class RecordSearch {
+public:
+    bool add(const Records::ServiceRecord &record);
+    void clear();
+
+    QVector<Records::ServiceRecord> search(const QString &query, int limit, int *total = nullptr) const;
+    int size() const;
+    TextIndex::Stats indexStats() const;
+    RecordColumns::Stats columnStats() const;
+
+    static QString documentText(const Records::ServiceRecord &record);
+
+private:
+    RecordColumns records;
+    // Hashes of phone, creation time, service date and notes; collisions are settled against the columns.
+    QMultiHash<size_t, int> keys;
+    TextIndex index;
+};
@@ -0,0 +1,166 @@
+#include "RecordStore.h"
+
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+bool flushToDisk(QFile &file) {
+    if (!file.flush()) {
+        return false;
+    }
+#ifdef Q_OS_WIN
+    return _commit(file.handle()) == 0;
+#else
+    return ::fsync(file.handle()) == 0;
+#endif
+}
+} // namespace
+
+RecordStore::RecordStore(const QString &directory) {
+    QString dir = directory;
+    if (dir.isEmpty()) {
+        dir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/sync";
+    }
+    QDir().mkpath(dir);
+    recordsPath = dir + "/records.jsonl";
+    statePath = dir + "/state.json";
+    loadState();
+}
+
+bool RecordStore::appendPage(const QJsonArray &rows, const QString &cursor) {
+    QFile file(recordsPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        errorText = file.errorString();
+        return false;
+    }
+    // Bytes past the commit point belong to a page that failed earlier and is being fetched again.
+    if (file.size() != current.bytes && !file.resize(current.bytes)) {
+        errorText = file.errorString();
+        return false;
+    }
+
+    State next = current;
+    next.cursor = cursor;
+    for (const auto &value : rows) {
+        file.write(QJsonDocument(value.toObject()).toJson(QJsonDocument::Compact) + '\n');
+        ++next.records;
+    }
+    if (!flushToDisk(file)) {
+        errorText = file.errorString();
+        file.resize(current.bytes);
+        return false;
+    }
+    next.bytes = file.size();
+
+    // The state file is the commit point: bytes past next.bytes are discarded on the next start.
+    const State previous = current;
+    current = next;
+    if (!saveState()) {
+        current = previous;
+        file.resize(current.bytes);
+        return false;
+    }
+    return true;
+}
+
+bool RecordStore::markSynced() {
+    current.lastSync = QDateTime::currentDateTime();
+    return saveState();
+}
+
+void RecordStore::reset() {
+    QFile::remove(recordsPath);
+    current = State();
+    saveState();
+}
+
+void RecordStore::forEach(const std::function<void(const QJsonObject &row)> &visit) const {
+    forEachIn(recordsPath, current.bytes, [&visit](const QJsonObject &row) {
+        visit(row);
+        return true;
+    });
+}
+
+QString RecordStore::recordsFile() const {
+    return recordsPath;
+}
+
+void RecordStore::forEachIn(const QString &path, qint64 bytes,
+                            const std::function<bool(const QJsonObject &row)> &visit) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    while (file.pos() < bytes && !file.atEnd()) {
+        const QByteArray raw = file.readLine().trimmed();
+        if (raw.isEmpty()) {
+            continue;
+        }
+        const QJsonDocument doc = QJsonDocument::fromJson(raw);
+        if (doc.isObject() && !visit(doc.object())) {
+            return;
+        }
+    }
+}
+
+const RecordStore::State &RecordStore::state() const {
+    return current;
+}
+
+QString RecordStore::lastError() const {
+    return errorText;
+}
+
+void RecordStore::loadState() {
+    QFile file(statePath);
+    if (file.open(QIODevice::ReadOnly)) {
+        const QJsonObject obj = QJsonDocument::fromJson(file.readAll()).object();
+        current.cursor = obj.value("cursor").toString();
+        current.records = obj.value("records").toInteger();
+        current.bytes = obj.value("bytes").toInteger();
+        current.lastSync = QDateTime::fromString(obj.value("last_sync").toString(), Qt::ISODate);
+        // A copy paged by created_at has no cursor and may have gaps, so it is fetched again from the start.
+        if (!obj.contains("cursor") && current.records > 0) {
+            reset();
+            return;
+        }
+    }
+
+    // Drop a page that was written but never committed, or start over if the data file is shorter than recorded.
+    QFile records(recordsPath);
+    const qint64 size = records.exists() ? records.size() : 0;
+    if (size > current.bytes) {
+        records.resize(current.bytes);
+    } else if (size < current.bytes) {
+        reset();
+    }
+}
+
+bool RecordStore::saveState() {
+    QJsonObject obj;
+    obj.insert("cursor", current.cursor);
+    obj.insert("records", current.records);
+    obj.insert("bytes", current.bytes);
+    obj.insert("last_sync", current.lastSync.toString(Qt::ISODate));
+
+    QSaveFile file(statePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        errorText = file.errorString();
+        return false;
+    }
+    file.write(QJsonDocument(obj).toJson(QJsonDocument::Compact));
+    if (!file.commit()) {
+        errorText = file.errorString();
+        return false;
+    }
+    return true;
+}
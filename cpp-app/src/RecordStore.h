@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QString>
+
+#include <functional>
+
+class RecordStore {
+public:
+    explicit RecordStore(const QString &directory = QString());
+
+    struct State {
+        // Opaque position from the endpoint; the next page starts after it.
+        QString cursor;
+        qint64 records = 0;
+        qint64 bytes = 0;
+        QDateTime lastSync;
+    };
+
+    bool appendPage(const QJsonArray &rows, const QString &cursor);
+    bool markSynced();
+    void reset();
+    void forEach(const std::function<void(const QJsonObject &row)> &visit) const;
+    QString recordsFile() const;
+
+    // Reads committed rows without touching the store, so it is safe from another thread; return false to stop.
+    static void forEachIn(const QString &path, qint64 bytes, const std::function<bool(const QJsonObject &row)> &visit);
+
+    const State &state() const;
+    QString lastError() const;
+
+private:
+    void loadState();
+    bool saveState();
+
+    QString recordsPath;
+    QString statePath;
+    State current;
+    QString errorText;
+};
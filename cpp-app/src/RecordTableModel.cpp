@@ -0,0 +1,122 @@
+#include "RecordTableModel.h"
+
+RecordTableModel::RecordTableModel(QObject *parent) : QAbstractTableModel(parent), headers(Records::displayHeaders()) {}
+
+void RecordTableModel::setRecords(const RecordList &records, bool onlyWater) {
+    if (records == source && onlyWater == waterOnly && appended.isEmpty()) {
+        return;
+    }
+
+    beginResetModel();
+    source = records;
+    appended.clear();
+    waterOnly = onlyWater;
+    visibleRows.clear();
+    if (source) {
+        visibleRows.reserve(source->size());
+        for (int i = 0; i < source->size(); ++i) {
+            if (Records::matches(source->at(i), onlyWater)) {
+                visibleRows.append(i);
+            }
+        }
+    }
+    endResetModel();
+}
+
+void RecordTableModel::appendRecords(const QVector<Records::ServiceRecord> &records, bool onlyWater) {
+    if (source || onlyWater != waterOnly) {
+        clear();
+        waterOnly = onlyWater;
+    }
+
+    QVector<int> added;
+    for (const auto &record : records) {
+        if (Records::matches(record, onlyWater)) {
+            appended.append(record);
+            added.append(appended.size() - 1);
+        }
+    }
+    if (added.isEmpty()) {
+        return;
+    }
+
+    const int before = visibleCount();
+    const int total = visibleRows.size() + added.size();
+    const int after = rowLimit >= 0 ? qMin(total, rowLimit) : total;
+    if (after > before) {
+        beginInsertRows(QModelIndex(), before, after - 1);
+        visibleRows += added;
+        endInsertRows();
+    } else {
+        visibleRows += added;
+    }
+}
+
+void RecordTableModel::setRowLimit(int limit) {
+    beginResetModel();
+    rowLimit = limit;
+    endResetModel();
+}
+
+void RecordTableModel::clear() {
+    if (!source && appended.isEmpty()) {
+        return;
+    }
+    beginResetModel();
+    source.reset();
+    appended.clear();
+    visibleRows.clear();
+    endResetModel();
+}
+
+const Records::ServiceRecord *RecordTableModel::recordAt(int row) const {
+    if (row < 0 || row >= visibleCount()) {
+        return nullptr;
+    }
+    const int index = visibleRows.at(row);
+    return source ? &source->at(index) : &appended.at(index);
+}
+
+RecordTableModel::RecordList RecordTableModel::snapshot() const {
+    if (source) {
+        return source;
+    }
+    return appended.isEmpty() ? RecordList() : std::make_shared<const QVector<Records::ServiceRecord>>(appended);
+}
+
+bool RecordTableModel::isWaterOnly() const {
+    return waterOnly;
+}
+
+int RecordTableModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : visibleCount();
+}
+
+int RecordTableModel::columnCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : headers.size();
+}
+
+QVariant RecordTableModel::data(const QModelIndex &index, int role) const {
+    if (role != Qt::DisplayRole && role != Qt::ToolTipRole) {
+        return {};
+    }
+    const Records::ServiceRecord *record = recordAt(index.row());
+    if (!record) {
+        return {};
+    }
+    return Records::displayCell(*record, index.column(), waterOnly);
+}
+
+QVariant RecordTableModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (role != Qt::DisplayRole) {
+        return {};
+    }
+    if (orientation == Qt::Vertical) {
+        return section + 1;
+    }
+    return headers.value(section);
+}
+
+int RecordTableModel::visibleCount() const {
+    return rowLimit >= 0 ? qMin(int(visibleRows.size()), rowLimit) : int(visibleRows.size());
+}
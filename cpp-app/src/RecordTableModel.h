@@ -0,0 +1,41 @@
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QVector>
+
+#include <memory>
+
+#include "Records.h"
+
+class RecordTableModel : public QAbstractTableModel {
+    Q_OBJECT
+
+public:
+    using RecordList = std::shared_ptr<const QVector<Records::ServiceRecord>>;
+
+    explicit RecordTableModel(QObject *parent = nullptr);
+
+    void setRecords(const RecordList &records, bool onlyWater);
+    void appendRecords(const QVector<Records::ServiceRecord> &records, bool onlyWater);
+    void setRowLimit(int limit);
+    void clear();
+
+    const Records::ServiceRecord *recordAt(int row) const;
+    RecordList snapshot() const;
+    bool isWaterOnly() const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+    int visibleCount() const;
+
+    RecordList source;
+    QVector<Records::ServiceRecord> appended;
+    QVector<int> visibleRows;
+    QStringList headers;
+    bool waterOnly = false;
+    int rowLimit = -1;
+};
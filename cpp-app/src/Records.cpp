@@ -0,0 +1,217 @@
+#include "Records.h"
+
+#include <QJsonDocument>
+
+#include <algorithm>
+#include <limits>
+
+#include "DateUtils.h"
+
+namespace Records {
+
+int cycleToMonths(const QString &cycle) {
+    if (cycle == QStringLiteral("半年")) {
+        return 6;
+    }
+    if (cycle == QStringLiteral("一年")) {
+        return 12;
+    }
+    if (cycle == QStringLiteral("一年半")) {
+        return 18;
+    }
+    if (cycle == QStringLiteral("兩年")) {
+        return 24;
+    }
+    return 0;
+}
+
+QStringList toStringList(const QJsonValue &value) {
+    if (value.isArray()) {
+        QStringList list;
+        for (const auto &item : value.toArray()) {
+            list.append(item.toString());
+        }
+        return list;
+    }
+
+    if (value.isString()) {
+        const QString text = value.toString();
+        if (text.trimmed().startsWith('[')) {
+            QJsonDocument doc = QJsonDocument::fromJson(text.toUtf8());
+            if (doc.isArray()) {
+                QStringList list;
+                for (const auto &item : doc.array()) {
+                    list.append(item.toString());
+                }
+                return list;
+            }
+        }
+    }
+    return {};
+}
+
+QString joinList(const QStringList &values) {
+    QStringList cleaned;
+    for (const auto &value : values) {
+        if (!value.trimmed().isEmpty()) {
+            cleaned.append(value.trimmed());
+        }
+    }
+    return cleaned.join(" / ");
+}
+
+quint8 itemMask(const QStringList &items) {
+    quint8 mask = 0;
+    for (const auto &item : items) {
+        const int index = kItems.indexOf(item);
+        if (index >= 0) {
+            mask |= quint8(1 << index);
+        }
+    }
+    return mask;
+}
+
+quint8 purposeMask(const QStringList &purposes) {
+    quint8 mask = 0;
+    for (const auto &purpose : purposes) {
+        const int index = kPurposes.indexOf(purpose);
+        if (index >= 0) {
+            mask |= quint8(1 << index);
+        }
+    }
+    return mask;
+}
+
+ServiceRecord decode(const QJsonObject &obj) {
+    ServiceRecord record;
+    record.serviceDate = DateUtils::rocToAdDate(obj.value("service_date_roc").toString(), &record.serviceDateRoc);
+    record.createdAt = QDateTime::fromString(obj.value("created_at").toString(), "yyyy-MM-dd HH:mm:ss");
+    record.serviceDay = record.serviceDate.toJulianDay();
+    record.createdMs = record.createdAt.isValid() ? record.createdAt.toMSecsSinceEpoch() : std::numeric_limits<qint64>::min();
+
+    const QStringList items = toStringList(obj.value("items"));
+    const QStringList purposes = toStringList(obj.value("purposes"));
+    record.itemMask = itemMask(items);
+    record.purposeMask = purposeMask(purposes);
+    record.itemsText = joinList(items);
+    record.purposesText = joinList(purposes);
+
+    record.customerName = obj.value("customer_name").toString();
+    record.phone = obj.value("phone").toString();
+    record.address = obj.value("address").toString();
+    record.otherItemText = obj.value("other_item_text").toString();
+    record.waterCycle = obj.value("water_replace_cycle").toString();
+    record.nextReplaceRoc = obj.value("next_replace_date_roc").toString().trimmed();
+    record.warrantyEndRoc = obj.value("warranty_end_date_roc").toString().trimmed();
+    record.notes = obj.value("notes").toString();
+    return record;
+}
+
+QVector<ServiceRecord> decodeRows(const QJsonArray &rows) {
+    QVector<ServiceRecord> records;
+    records.reserve(rows.size());
+    for (const auto &value : rows) {
+        if (value.isObject()) {
+            records.append(decode(value.toObject()));
+        }
+    }
+    return records;
+}
+
+void sortNewestFirst(QVector<ServiceRecord> &records) {
+    std::sort(records.begin(), records.end(), [](const ServiceRecord &a, const ServiceRecord &b) {
+        if (a.serviceDay != b.serviceDay) {
+            return a.serviceDay > b.serviceDay;
+        }
+        return a.createdMs > b.createdMs;
+    });
+}
+
+void assignWaterRanks(QVector<ServiceRecord> &records) {
+    int rank = 0;
+    for (auto &record : records) {
+        record.waterRank = (record.itemMask & WaterItem) ? rank++ : -1;
+    }
+}
+
+int latestCreatedIndex(const QVector<ServiceRecord> &records) {
+    int latest = -1;
+    for (int i = 0; i < records.size(); ++i) {
+        if (latest < 0 || !records[latest].createdAt.isValid() || records[i].createdMs > records[latest].createdMs) {
+            latest = i;
+        }
+    }
+    return latest;
+}
+
+bool matches(const ServiceRecord &record, bool onlyWater) {
+    return !onlyWater || (record.itemMask & WaterItem);
+}
+
+QStringList displayHeaders() {
+    return {
+        "日期(民國)",
+        "姓名",
+        "電話",
+        "地址",
+        "用途(安裝/購買)",
+        "項目",
+        "淨水狀態",
+        "更換日期或保固期限",
+        "備註"
+    };
+}
+
+QString displayCell(const ServiceRecord &record, int column, bool onlyWater) {
+    switch (column) {
+    case 0:
+        return record.serviceDateRoc;
+    case 1:
+        return record.customerName;
+    case 2:
+        return record.phone;
+    case 3:
+        return record.address;
+    case 4:
+        return record.purposesText;
+    case 5:
+        return onlyWater ? kWaterItem : record.itemsText;
+    case 6:
+        if (record.waterRank == 0) {
+            return QStringLiteral("未更換");
+        }
+        return record.waterRank > 0 ? QStringLiteral("已更換") : QString();
+    case 7: {
+        const QString &nextReplace = record.nextReplaceRoc;
+        const QString &warrantyEnd = record.warrantyEndRoc;
+        if (onlyWater) {
+            return nextReplace.isEmpty() ? QString() : QString("更換：%1").arg(nextReplace);
+        }
+        if (!nextReplace.isEmpty() && !warrantyEnd.isEmpty()) {
+            return QString("更換：%1 / 保固：%2").arg(nextReplace, warrantyEnd);
+        }
+        if (!nextReplace.isEmpty()) {
+            return QString("更換：%1").arg(nextReplace);
+        }
+        if (!warrantyEnd.isEmpty()) {
+            return QString("保固：%1").arg(warrantyEnd);
+        }
+        return {};
+    }
+    case 8:
+        return record.notes;
+    default:
+        return {};
+    }
+}
+
+QStringList displayRow(const ServiceRecord &record, bool onlyWater) {
+    QStringList row;
+    row.reserve(kColumnCount);
+    for (int column = 0; column < kColumnCount; ++column) {
+        row.append(displayCell(record, column, onlyWater));
+    }
+    return row;
+}
+
+} // namespace Records
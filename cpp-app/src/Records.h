@@ -0,0 +1,80 @@
+#pragma once
+
+#include <QDate>
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace Records {
+inline const QString kWaterItem = QStringLiteral("淨水設備");
+inline const QString kGasItem = QStringLiteral("瓦斯爐具器具");
+inline const QString kOtherItem = QStringLiteral("其他（自行輸入）");
+
+inline const QStringList kItems = {
+    QStringLiteral("淨水設備"),
+    QStringLiteral("瓦斯爐具器具"),
+    QStringLiteral("系統櫃廚具"),
+    QStringLiteral("水電及室內裝修工程"),
+    QStringLiteral("其他（自行輸入）")
+};
+
+inline const QStringList kPurposes = {QStringLiteral("安裝"), QStringLiteral("購買")};
+
+inline const QStringList kWaterCycles = {QStringLiteral("半年"), QStringLiteral("一年"), QStringLiteral("一年半"), QStringLiteral("兩年")};
+
+inline constexpr int kColumnCount = 9;
+
+enum ItemFlag : quint8 {
+    WaterItem = 1 << 0,
+    GasItem = 1 << 1,
+    CabinetItem = 1 << 2,
+    RenovationItem = 1 << 3,
+    OtherItem = 1 << 4
+};
+
+enum PurposeFlag : quint8 {
+    InstallPurpose = 1 << 0,
+    BuyPurpose = 1 << 1
+};
+
+struct ServiceRecord {
+    qint64 serviceDay = 0;
+    qint64 createdMs = 0;
+    QDate serviceDate;
+    QDateTime createdAt;
+    QString serviceDateRoc;
+    QString customerName;
+    QString phone;
+    QString address;
+    QString itemsText;
+    QString purposesText;
+    QString otherItemText;
+    QString waterCycle;
+    QString nextReplaceRoc;
+    QString warrantyEndRoc;
+    QString notes;
+    quint8 itemMask = 0;
+    quint8 purposeMask = 0;
+    int waterRank = -1;
+};
+
+int cycleToMonths(const QString &cycle);
+QStringList toStringList(const QJsonValue &value);
+QString joinList(const QStringList &values);
+quint8 itemMask(const QStringList &items);
+quint8 purposeMask(const QStringList &purposes);
+
+ServiceRecord decode(const QJsonObject &obj);
+QVector<ServiceRecord> decodeRows(const QJsonArray &rows);
+void sortNewestFirst(QVector<ServiceRecord> &records);
+void assignWaterRanks(QVector<ServiceRecord> &records);
+int latestCreatedIndex(const QVector<ServiceRecord> &records);
+
+bool matches(const ServiceRecord &record, bool onlyWater);
+QStringList displayHeaders();
+QString displayCell(const ServiceRecord &record, int column, bool onlyWater);
+QStringList displayRow(const ServiceRecord &record, bool onlyWater);
+} // namespace Records
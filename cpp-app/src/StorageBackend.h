@@ -0,0 +1,63 @@
+#pragma once
+
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QString>
+
+#include <functional>
+
+// Where records are read from and written to: the Apps Script endpoint (ApiClient) or the local store (LocalBackend).
+// Handlers always run on the thread that owns the backend, after the call has returned.
+class StorageBackend : public QObject {
+    Q_OBJECT
+
+public:
+    explicit StorageBackend(QObject *parent = nullptr) : QObject(parent) {}
+
+    struct Result {
+        bool ok = false;
+        QString message;
+        QJsonArray rows;
+        bool fromCache = false;
+        QDateTime fetchedAt;
+        bool hasMore = false;
+        // Delta sync only: the opaque position after the last row of this page.
+        QString cursor;
+        // The endpoint answered and refused this record; sending it again will not help.
+        bool rejected = false;
+    };
+
+    struct BatchResult {
+        bool ok = false;
+        QString message;
+        QList<Result> records;
+    };
+
+    using ResultHandler = std::function<void(const Result &)>;
+    using BatchHandler = std::function<void(const BatchResult &)>;
+    using RowsHandler = std::function<void(const QJsonArray &chunk)>;
+    using Ticket = quint64;
+    using CustomerVisitor = std::function<void(const QString &phone, const QJsonArray &rows)>;
+    using CustomerSource = std::function<void(const CustomerVisitor &visit)>;
+
+    virtual void postRecordAsync(const QJsonObject &data, ResultHandler handler) = 0;
+    virtual void postRecordsAsync(const QList<QJsonObject> &records, BatchHandler handler) = 0;
+    virtual Ticket getRecordsAsync(const QString &phone, bool onlyWater, ResultHandler handler, RowsHandler onRows = RowsHandler()) = 0;
+    virtual Ticket fetchRawAsync(const QString &phone, ResultHandler handler) = 0;
+    // Never a copy older than maxAgeSecs: a recent enough local copy if there is one, otherwise the store's answer.
+    virtual Ticket fetchRecentAsync(const QString &phone, qint64 maxAgeSecs, ResultHandler handler) = 0;
+    // Rows in the order the store accepted them, starting after the cursor of an earlier page ("" for the first).
+    virtual Ticket fetchSyncPageAsync(const QString &after, int limit, ResultHandler handler) = 0;
+    virtual void cancel(Ticket ticket) = 0;
+
+    // Reads every customer whose records are already on this machine, without a round trip. The reader works on a
+    // snapshot of the index and its own file handles, so it can run on another thread.
+    virtual CustomerSource cachedCustomers() const = 0;
+
+    virtual bool isLocal() const {
+        return false;
+    }
+};
@@ -0,0 +1,114 @@
+#include "SyncEngine.h"
+
+namespace {
+const int kPageSize = 500;
+const int kSyncIntervalMs = 5 * 60 * 1000;
+const int kMinRetryMs = 1000;
+const int kMaxRetryMs = 5 * 60 * 1000;
+} // namespace
+
+SyncEngine::SyncEngine(StorageBackend *client, const QString &directory, QObject *parent)
+    : QObject(parent), client(client), records(directory) {
+    // A local store already serves the due list and export from its own log, so there is nothing to copy.
+    enabled = qEnvironmentVariableIntValue("MAINTENANCE_LOG_SYNC") != 0 && !client->isLocal();
+
+    retryTimer.setSingleShot(true);
+    connect(&retryTimer, &QTimer::timeout, this, &SyncEngine::fetchNextPage);
+
+    intervalTimer.setSingleShot(true);
+    intervalTimer.setInterval(kSyncIntervalMs);
+    connect(&intervalTimer, &QTimer::timeout, this, &SyncEngine::start);
+}
+
+void SyncEngine::start() {
+    if (!enabled || running) {
+        return;
+    }
+    running = true;
+    fetchedThisRun = 0;
+    runTimer.start();
+    intervalTimer.stop();
+    emit statusChanged();
+    fetchNextPage();
+}
+
+bool SyncEngine::isEnabled() const {
+    return enabled;
+}
+
+bool SyncEngine::isRunning() const {
+    return running;
+}
+
+const RecordStore &SyncEngine::store() const {
+    return records;
+}
+
+qint64 SyncEngine::runRecords() const {
+    return fetchedThisRun;
+}
+
+double SyncEngine::rowsPerSecond() const {
+    const qint64 elapsed = running ? runTimer.elapsed() : runElapsedMs;
+    return elapsed > 0 ? fetchedThisRun * 1000.0 / elapsed : 0.0;
+}
+
+QString SyncEngine::lastError() const {
+    return errorText;
+}
+
+void SyncEngine::fetchNextPage() {
+    const QString cursor = records.state().cursor;
+    client->fetchSyncPageAsync(cursor, kPageSize, [this, cursor](const StorageBackend::Result &result) {
+        handlePage(cursor, result);
+    });
+}
+
+void SyncEngine::handlePage(const QString &cursor, const StorageBackend::Result &result) {
+    if (!result.ok) {
+        errorText = result.message;
+        scheduleRetry();
+        emit statusChanged();
+        return;
+    }
+    // Storing rows without moving the cursor would fetch and store the same page again, forever.
+    if (!result.rows.isEmpty() && (result.cursor.isEmpty() || result.cursor == cursor)) {
+        errorText = QString::fromUtf8("同步回應缺少新的 next 游標");
+        scheduleRetry();
+        emit statusChanged();
+        return;
+    }
+    if (!result.rows.isEmpty() && !records.appendPage(result.rows, result.cursor)) {
+        errorText = records.lastError();
+        scheduleRetry();
+        emit statusChanged();
+        return;
+    }
+
+    retryDelayMs = 0;
+    errorText.clear();
+    fetchedThisRun += result.rows.size();
+    if (!result.rows.isEmpty()) {
+        emit pageStored(result.rows);
+    }
+
+    if (!result.rows.isEmpty() && (result.hasMore || result.rows.size() >= kPageSize)) {
+        emit statusChanged();
+        fetchNextPage();
+        return;
+    }
+    finishRun();
+}
+
+void SyncEngine::finishRun() {
+    running = false;
+    runElapsedMs = runTimer.elapsed();
+    records.markSynced();
+    intervalTimer.start();
+    emit statusChanged();
+}
+
+void SyncEngine::scheduleRetry() {
+    retryDelayMs = retryDelayMs == 0 ? kMinRetryMs : qMin(retryDelayMs * 2, kMaxRetryMs);
+    retryTimer.start(retryDelayMs);
+}
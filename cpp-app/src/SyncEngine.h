@@ -0,0 +1,48 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+#include "StorageBackend.h"
+#include "RecordStore.h"
+
+class SyncEngine : public QObject {
+    Q_OBJECT
+
+public:
+    explicit SyncEngine(StorageBackend *client, const QString &directory = QString(), QObject *parent = nullptr);
+
+    void start();
+
+    bool isEnabled() const;
+    bool isRunning() const;
+    const RecordStore &store() const;
+    qint64 runRecords() const;
+    double rowsPerSecond() const;
+    QString lastError() const;
+
+signals:
+    void pageStored(const QJsonArray &rows);
+    void statusChanged();
+
+private:
+    void fetchNextPage();
+    void handlePage(const QString &cursor, const StorageBackend::Result &result);
+    void finishRun();
+    void scheduleRetry();
+
+    StorageBackend *client = nullptr;
+    RecordStore records;
+    bool enabled = false;
+    bool running = false;
+    int retryDelayMs = 0;
+    qint64 fetchedThisRun = 0;
+    QElapsedTimer runTimer;
+    qint64 runElapsedMs = 0;
+    QString errorText;
+    QTimer retryTimer;
+    QTimer intervalTimer;
+};
@@ -0,0 +1,161 @@
+#include "TextIndex.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace {
+enum CharClass { Separator, Word, Cjk };
+
+// Rough per-term cost of a QHash node, not counting the key's characters.
+const int kTermOverheadBytes = 64;
+// Longest gram indexed for a Latin or digit run.
+const qsizetype kWordGram = 3;
+
+CharClass classify(QChar c) {
+    if (!c.isLetterOrNumber()) {
+        return Separator;
+    }
+    switch (c.script()) {
+    case QChar::Script_Han:
+    case QChar::Script_Hiragana:
+    case QChar::Script_Katakana:
+    case QChar::Script_Hangul:
+    case QChar::Script_Bopomofo:
+        return Cjk;
+    default:
+        return Word;
+    }
+}
+
+void appendVarint(QByteArray &out, quint32 value) {
+    while (value >= 0x80) {
+        out.append(char((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.append(char(value));
+}
+
+QVector<quint32> decode(const QByteArray &bytes, quint32 count) {
+    QVector<quint32> ids;
+    ids.reserve(count);
+    quint32 current = 0;
+    quint32 value = 0;
+    int shift = 0;
+    for (const char byte : bytes) {
+        value |= quint32(quint8(byte) & 0x7f) << shift;
+        if (quint8(byte) & 0x80) {
+            shift += 7;
+            continue;
+        }
+        current += value;
+        ids.append(current);
+        value = 0;
+        shift = 0;
+    }
+    return ids;
+}
+} // namespace
+
+quint32 TextIndex::addDocument(const QString &text) {
+    const quint32 id = documentCount++;
+    for (const auto &term : tokenize(text, false)) {
+        Posting &posting = postings[term];
+        if (posting.count > 0 && posting.last == id) {
+            continue;
+        }
+        appendVarint(posting.bytes, posting.count == 0 ? id : id - posting.last);
+        posting.last = id;
+        ++posting.count;
+    }
+    return id;
+}
+
+QVector<quint32> TextIndex::search(const QString &query) const {
+    QVector<const Posting *> lists;
+    for (const auto &term : tokenize(query, true)) {
+        const auto it = postings.constFind(term);
+        if (it == postings.constEnd()) {
+            return {};
+        }
+        lists.append(&it.value());
+    }
+    if (lists.isEmpty()) {
+        return {};
+    }
+
+    std::sort(lists.begin(), lists.end(), [](const Posting *a, const Posting *b) { return a->count < b->count; });
+    QVector<quint32> result = decode(lists.first()->bytes, lists.first()->count);
+    for (int i = 1; i < lists.size() && !result.isEmpty(); ++i) {
+        const QVector<quint32> other = decode(lists.at(i)->bytes, lists.at(i)->count);
+        QVector<quint32> both;
+        std::set_intersection(result.cbegin(), result.cend(), other.cbegin(), other.cend(), std::back_inserter(both));
+        result = both;
+    }
+    return result;
+}
+
+void TextIndex::clear() {
+    postings.clear();
+    documentCount = 0;
+}
+
+TextIndex::Stats TextIndex::stats() const {
+    Stats stats;
+    stats.documents = documentCount;
+    stats.terms = postings.size();
+    for (auto it = postings.cbegin(); it != postings.cend(); ++it) {
+        stats.postings += it->count;
+        stats.postingBytes += it->bytes.capacity();
+        stats.approxBytes += kTermOverheadBytes + it.key().size() * qsizetype(sizeof(QChar)) + it->bytes.capacity();
+    }
+    return stats;
+}
+
+QString TextIndex::fold(const QString &text) {
+    return text.normalized(QString::NormalizationForm_KC).toCaseFolded();
+}
+
+QStringList TextIndex::tokenize(const QString &text, bool forQuery) {
+    const QString folded = fold(text);
+    QStringList terms;
+    qsizetype start = 0;
+    while (start < folded.size()) {
+        const CharClass kind = classify(folded.at(start));
+        qsizetype end = start + 1;
+        while (end < folded.size() && classify(folded.at(end)) == kind) {
+            ++end;
+        }
+
+        const qsizetype length = end - start;
+        if (kind == Word) {
+            // Latin and digit runs are indexed as every gram of up to three characters, so part of a word or
+            // number matches too; a query uses its trigrams, or the whole run when it is shorter.
+            if (forQuery) {
+                if (length < kWordGram) {
+                    terms.append(folded.mid(start, length));
+                }
+                for (qsizetype i = start; i + kWordGram <= end; ++i) {
+                    terms.append(folded.mid(i, kWordGram));
+                }
+            } else {
+                for (qsizetype i = start; i < end; ++i) {
+                    for (qsizetype n = 1; n <= kWordGram && i + n <= end; ++n) {
+                        terms.append(folded.mid(i, n));
+                    }
+                }
+            }
+        } else if (kind == Cjk) {
+            // Documents carry unigrams and bigrams; a query uses bigrams unless the run is a single character.
+            if (!forQuery || length == 1) {
+                for (qsizetype i = start; i < end; ++i) {
+                    terms.append(folded.mid(i, 1));
+                }
+            }
+            for (qsizetype i = start; i + 1 < end; ++i) {
+                terms.append(folded.mid(i, 2));
+            }
+        }
+        start = end;
+    }
+    return terms;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class TextIndex {
+public:
+    struct Stats {
+        qint64 documents = 0;
+        qint64 terms = 0;
+        qint64 postings = 0;
+        qint64 postingBytes = 0;
+        qint64 approxBytes = 0;
+    };
+
+    quint32 addDocument(const QString &text);
+    QVector<quint32> search(const QString &query) const;
+    void clear();
+
+    Stats stats() const;
+
+    static QString fold(const QString &text);
+    static QStringList tokenize(const QString &text, bool forQuery);
+
+private:
+    struct Posting {
+        QByteArray bytes;
+        quint32 last = 0;
+        quint32 count = 0;
+    };
+
+    QHash<QString, Posting> postings;
+    quint32 documentCount = 0;
+};
@@ -0,0 +1,236 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QSysInfo>
+#include <QThread>
+#include <QTimer>
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+
+#include "ApiClient.h"
+#include "Perf.h"
+#include "StandInServer.h"
+
+namespace {
+struct Outcome {
+    qint64 ok = 0;
+    qint64 failed = 0;
+};
+
+QString customerPhone(const QString &prefix, qint64 base, qint64 index) {
+    return QString("%1%2").arg(prefix).arg((base + index) % 100000000, 8, 10, QChar('0'));
+}
+
+QJsonObject stageJson(const Perf::StageStats &stage) {
+    QJsonObject obj;
+    obj.insert("name", stage.name);
+    obj.insert("count", stage.count);
+    obj.insert("p50_ms", stage.p50Ms);
+    obj.insert("p95_ms", stage.p95Ms);
+    obj.insert("p99_ms", stage.p99Ms);
+    obj.insert("max_ms", stage.maxMs);
+    obj.insert("total_ms", stage.totalMs);
+    return obj;
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Drives ApiClient with concurrent lookups and writes and reports throughput and tail latency");
+    parser.addHelpOption();
+    QCommandLineOption endpointOption("endpoint", "Endpoint to load. Without it a stand-in endpoint runs on a worker thread.", "url");
+    QCommandLineOption lookupsOption("lookups", "Customer lookups to send.", "count", "1000");
+    QCommandLineOption writesOption("writes", "Records to post.", "count", "200");
+    QCommandLineOption concurrencyOption("concurrency", "Calls in flight at once.", "count", "8");
+    QCommandLineOption customersOption("customers", "Distinct phones to look up (0: one per lookup).", "count", "0");
+    QCommandLineOption batchSizeOption("batch-size", "Records per write call; above 1 writes go through postRecordsAsync.", "count", "1");
+    QCommandLineOption batchPostOption("batch-post", "Send write batches as one customer_service_batch POST.");
+    QCommandLineOption outputOption("output", "Write JSON results to this file instead of stdout.", "path");
+    parser.addOptions({endpointOption, lookupsOption, writesOption, concurrencyOption, customersOption, batchSizeOption,
+                       batchPostOption, outputOption});
+    StandInServer::addOptions(parser);
+    parser.process(app);
+
+    const int lookups = qMax(0, parser.value(lookupsOption).toInt());
+    const int writes = qMax(0, parser.value(writesOption).toInt());
+    const int concurrency = qMax(1, parser.value(concurrencyOption).toInt());
+    const int customers = parser.value(customersOption).toInt() > 0 ? parser.value(customersOption).toInt() : qMax(1, lookups);
+    const int batchSize = qMax(1, parser.value(batchSizeOption).toInt());
+    const int writeCalls = (writes + batchSize - 1) / batchSize;
+
+    QThread serverThread;
+    StandInServer *server = nullptr;
+    QString endpoint = parser.value(endpointOption);
+    if (endpoint.isEmpty()) {
+        StandInServer::Config config = StandInServer::configFromOptions(parser);
+        if (!parser.isSet("port")) {
+            config.port = 0;
+        }
+        server = new StandInServer(config);
+        server->moveToThread(&serverThread);
+        QObject::connect(&serverThread, &QThread::finished, server, &QObject::deleteLater);
+        serverThread.start();
+        bool listening = false;
+        QMetaObject::invokeMethod(server, [server, &listening]() { listening = server->listen(); }, Qt::BlockingQueuedConnection);
+        if (!listening) {
+            std::fprintf(stderr, "cannot start the stand-in endpoint: %s\n", server->errorString().toUtf8().constData());
+            serverThread.quit();
+            serverThread.wait();
+            return 2;
+        }
+        endpoint = server->url();
+    }
+
+    Perf::setEnabled(true);
+    Perf::reset();
+
+    ApiClient client;
+    client.setEndpointUrl(endpoint);
+    client.setBatchPostEnabled(parser.isSet(batchPostOption));
+    const qint64 cacheHitsBefore = client.cacheStats().hits;
+
+    // Phones start at a per-run offset so that the on-disk cache of an earlier run does not answer them.
+    const qint64 phoneBase = QDateTime::currentSecsSinceEpoch() % 100000 * 1000;
+    QRandomGenerator order(parser.value("seed").toUInt());
+    QVector<bool> ops(lookups, false);
+    ops.append(QVector<bool>(writeCalls, true));
+    std::shuffle(ops.begin(), ops.end(), order);
+
+    Outcome lookupOutcome;
+    Outcome writeOutcome;
+    QHash<QString, int> failures;
+    qint64 rowsReceived = 0;
+    int next = 0;
+    int inFlight = 0;
+    int lookupIndex = 0;
+    int writeIndex = 0;
+    QElapsedTimer wall;
+
+    std::function<void()> launchNext;
+    const auto complete = [&](Outcome &outcome, const char *stage, qint64 startNs, bool ok, const QString &message) {
+        Perf::record(stage, startNs, Perf::nowNs() - startNs);
+        if (ok) {
+            ++outcome.ok;
+        } else {
+            ++outcome.failed;
+            ++failures[message.section('\n', 0, 0)];
+        }
+        --inFlight;
+        launchNext();
+    };
+    launchNext = [&]() {
+        while (inFlight < concurrency && next < ops.size()) {
+            const bool write = ops.at(next++);
+            const qint64 startNs = Perf::nowNs();
+            ++inFlight;
+            if (write) {
+                QList<QJsonObject> records;
+                for (int i = 0; i < batchSize && writeIndex < writes; ++i, ++writeIndex) {
+                    records.append(StandInServer::syntheticRow(customerPhone("08", phoneBase, writeIndex), writeIndex,
+                                                               QDateTime::currentDateTime()));
+                }
+                if (records.size() == 1) {
+                    client.postRecordAsync(records.first(), [&, startNs](const ApiClient::Result &result) {
+                        complete(writeOutcome, "load.write", startNs, result.ok, result.message);
+                    });
+                } else {
+                    client.postRecordsAsync(records, [&, startNs](const ApiClient::BatchResult &result) {
+                        complete(writeOutcome, "load.write", startNs, result.ok, result.message);
+                    });
+                }
+            } else {
+                const QString phone = customerPhone("09", phoneBase, lookupIndex++ % customers);
+                client.getRecordsAsync(phone, false, [&, startNs](const ApiClient::Result &result) {
+                    if (result.fromCache) {
+                        return; // A stale cached copy; the downloaded answer follows.
+                    }
+                    rowsReceived += result.rows.size();
+                    complete(lookupOutcome, "load.lookup", startNs, result.ok, result.message);
+                });
+            }
+        }
+        if (inFlight == 0 && next >= ops.size()) {
+            QCoreApplication::quit();
+        }
+    };
+
+    wall.start();
+    QTimer::singleShot(0, &app, [&launchNext]() { launchNext(); });
+    app.exec();
+    const double elapsedMs = wall.nsecsElapsed() / 1e6;
+
+    StandInServer::Stats serverStats;
+    if (server) {
+        QMetaObject::invokeMethod(server, [server, &serverStats]() { serverStats = server->stats(); }, Qt::BlockingQueuedConnection);
+        serverThread.quit();
+        serverThread.wait();
+    }
+
+    const ApiClient::NetworkStats net = client.networkStats();
+    QJsonArray stages;
+    for (const auto &stage : Perf::snapshot()) {
+        stages.append(stageJson(stage));
+        std::fprintf(stderr, "%-28s count=%-8lld p50_ms=%9.3f p95_ms=%9.3f p99_ms=%9.3f max_ms=%9.3f\n",
+                     stage.name.toUtf8().constData(), stage.count, stage.p50Ms, stage.p95Ms, stage.p99Ms, stage.maxMs);
+    }
+    QJsonObject errors;
+    for (auto it = failures.cbegin(); it != failures.cend(); ++it) {
+        errors.insert(it.key(), it.value());
+    }
+    const double seconds = qMax(elapsedMs, 1.0) / 1000.0;
+    std::fprintf(stderr, "%d calls in %.1f ms: %.1f calls/s, %lld failed, %d records written\n",
+                 int(ops.size()), elapsedMs, ops.size() / seconds, lookupOutcome.failed + writeOutcome.failed, writeIndex);
+
+    QJsonObject root;
+    root.insert("suite", "MaintenanceLogLoadGen");
+    root.insert("timestamp", QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+    root.insert("qt_version", QString::fromLatin1(qVersion()));
+    root.insert("os", QSysInfo::prettyProductName());
+    root.insert("endpoint", endpoint);
+    root.insert("stand_in", server != nullptr);
+    root.insert("concurrency", concurrency);
+    root.insert("batch_size", batchSize);
+    root.insert("batch_post", client.batchPostEnabled());
+    root.insert("elapsed_ms", elapsedMs);
+    root.insert("calls_per_s", ops.size() / seconds);
+    root.insert("records_written_per_s", writeIndex / seconds);
+    root.insert("lookups", QJsonObject{{"ok", lookupOutcome.ok}, {"failed", lookupOutcome.failed}, {"rows", rowsReceived}});
+    root.insert("writes", QJsonObject{{"ok", writeOutcome.ok}, {"failed", writeOutcome.failed}, {"records", writeIndex}});
+    root.insert("cache_hits", client.cacheStats().hits - cacheHitsBefore);
+    root.insert("errors", errors);
+    root.insert("network", QJsonObject{{"requests", net.requests},
+                                       {"new_connections", net.newConnections},
+                                       {"bytes_received", net.bytesReceived},
+                                       {"wire_bytes_received", net.wireBytesReceived},
+                                       {"avg_first_byte_ms", net.avgFirstByteMs}});
+    if (server) {
+        root.insert("server", QJsonObject{{"requests", serverStats.requests},
+                                          {"injected_errors", serverStats.injectedErrors},
+                                          {"injected_non_json", serverStats.injectedNonJson},
+                                          {"records_stored", serverStats.recordsStored}});
+    }
+    root.insert("stages", stages);
+    const QByteArray json = QJsonDocument(root).toJson();
+
+    const QString outputPath = parser.value(outputOption);
+    if (outputPath.isEmpty()) {
+        std::fwrite(json.constData(), 1, json.size(), stdout);
+    } else {
+        QFile file(outputPath);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size()) {
+            std::fprintf(stderr, "cannot write %s\n", outputPath.toUtf8().constData());
+            return 2;
+        }
+    }
+    return lookupOutcome.failed + writeOutcome.failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,45 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTimer>
+
+#include <cstdio>
+
+#include "StandInServer.h"
+
+namespace {
+const int kStatsIntervalMs = 10 * 1000;
+} // namespace
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Local stand-in for the Maintenance Log Apps Script endpoint");
+    parser.addHelpOption();
+    StandInServer::addOptions(parser);
+    parser.process(app);
+
+    StandInServer server(StandInServer::configFromOptions(parser));
+    if (!server.listen()) {
+        std::fprintf(stderr, "cannot listen: %s\n", server.errorString().toUtf8().constData());
+        return 2;
+    }
+    std::fprintf(stderr, "listening on %s\nrun the app with MAINTENANCE_LOG_ENDPOINT=%s\n",
+                 server.url().toUtf8().constData(), server.url().toUtf8().constData());
+
+    QTimer statsTimer;
+    qint64 lastRequests = 0;
+    QObject::connect(&statsTimer, &QTimer::timeout, &server, [&server, &lastRequests]() {
+        const StandInServer::Stats stats = server.stats();
+        if (stats.requests == lastRequests) {
+            return;
+        }
+        std::fprintf(stderr, "requests=%lld (+%lld) lookups=%lld sync_pages=%lld posts=%lld stored=%lld errors=%lld non_json=%lld\n",
+                     stats.requests, stats.requests - lastRequests, stats.lookups, stats.syncPages, stats.posts,
+                     stats.recordsStored, stats.injectedErrors, stats.injectedNonJson);
+        lastRequests = stats.requests;
+    });
+    statsTimer.start(kStatsIntervalMs);
+
+    return app.exec();
+}
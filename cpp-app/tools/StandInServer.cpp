@@ -0,0 +1,357 @@
+#include "StandInServer.h"
+
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QHostAddress>
+#include <QJsonDocument>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUrl>
+
+#include "Compression.h"
+#include "DateUtils.h"
+#include "Records.h"
+
+namespace {
+const qsizetype kMaxHeaderBytes = 64 * 1024;
+const int kMinGzipBytes = 1024;
+const qint64 kCustomerSpanSecs = 10LL * 365 * 24 * 3600;
+const qint64 kDatasetStepSecs = 6 * 3600;
+const char *kLoginPage =
+    "<!DOCTYPE html><html><head><title>Google Accounts</title></head>"
+    "<body>Sign in to continue to Google Apps Script</body></html>";
+
+QByteArray reasonPhrase(int status) {
+    switch (status) {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 405: return "Method Not Allowed";
+    case 411: return "Length Required";
+    case 413: return "Payload Too Large";
+    case 415: return "Unsupported Media Type";
+    default: return "Internal Server Error";
+    }
+}
+
+StandInServer::Response jsonResponse(const QJsonObject &obj) {
+    StandInServer::Response response;
+    response.body = QJsonDocument(obj).toJson(QJsonDocument::Compact);
+    return response;
+}
+
+StandInServer::Response envelopeError(const QString &message) {
+    return jsonResponse(QJsonObject{{"ok", false}, {"error", message}});
+}
+
+StandInServer::Response textResponse(int status, const QByteArray &text) {
+    StandInServer::Response response;
+    response.status = status;
+    response.contentType = "text/plain; charset=utf-8";
+    response.body = text;
+    return response;
+}
+} // namespace
+
+StandInServer::StandInServer(const Config &config, QObject *parent)
+    : QObject(parent), config(config), tcp(new QTcpServer(this)), rng(config.seed) {
+    connect(tcp, &QTcpServer::newConnection, this, &StandInServer::acceptConnections);
+    buildDataset();
+}
+
+bool StandInServer::listen() {
+    return tcp->listen(QHostAddress(config.host), config.port);
+}
+
+quint16 StandInServer::port() const {
+    return tcp->serverPort();
+}
+
+QString StandInServer::url() const {
+    return QString("http://%1:%2/exec").arg(config.host).arg(port());
+}
+
+QString StandInServer::errorString() const {
+    return tcp->errorString();
+}
+
+StandInServer::Stats StandInServer::stats() const {
+    return counters;
+}
+
+void StandInServer::addOptions(QCommandLineParser &parser) {
+    parser.addOptions({
+        {"host", "Address the stand-in endpoint listens on.", "address", "127.0.0.1"},
+        {"port", "Port of the stand-in endpoint (0 picks a free one).", "port", "8765"},
+        {"rows", "Rows returned per customer lookup.", "count", "20"},
+        {"dataset", "Rows served by the delta-sync query.", "count", "10000"},
+        {"latency", "Added delay before every reply.", "ms", "0"},
+        {"jitter", "Extra random delay of up to this many milliseconds.", "ms", "0"},
+        {"error-rate", "Fraction of requests answered with HTTP 500.", "fraction", "0"},
+        {"non-json-rate", "Fraction of requests answered with an HTML page.", "fraction", "0"},
+        {"max-body", "POST bodies above this size get HTTP 413.", "bytes", "4194304"},
+        {"no-gzip", "Never gzip replies, even when the client accepts it."},
+        {"seed", "Seed for synthetic rows and injected faults.", "number", "1"},
+    });
+}
+
+StandInServer::Config StandInServer::configFromOptions(const QCommandLineParser &parser) {
+    Config config;
+    config.host = parser.value("host");
+    config.port = quint16(parser.value("port").toUInt());
+    config.rowsPerCustomer = qMax(0, parser.value("rows").toInt());
+    config.datasetRows = qMax(0, parser.value("dataset").toInt());
+    config.latencyMs = qMax(0, parser.value("latency").toInt());
+    config.jitterMs = qMax(0, parser.value("jitter").toInt());
+    config.errorRate = qBound(0.0, parser.value("error-rate").toDouble(), 1.0);
+    config.nonJsonRate = qBound(0.0, parser.value("non-json-rate").toDouble(), 1.0);
+    config.maxBodyBytes = qMax<qint64>(1, parser.value("max-body").toLongLong());
+    config.gzipResponses = !parser.isSet("no-gzip");
+    config.seed = parser.value("seed").toUInt();
+    return config;
+}
+
+QJsonObject StandInServer::syntheticRow(const QString &phone, int index, const QDateTime &createdAt) {
+    const bool water = index % 3 == 0;
+    const QDate serviceDate = createdAt.date();
+    const QString nextYear = DateUtils::dateToRoc(DateUtils::addOneYear(serviceDate));
+
+    QJsonObject row;
+    row.insert("service_date_ad", DateUtils::dateToIso(serviceDate));
+    row.insert("service_date_roc", DateUtils::dateToRoc(serviceDate));
+    row.insert("customer_name", QString("客戶%1").arg(phone.right(3)));
+    row.insert("phone", phone);
+    row.insert("address", QString("台北市信義區信義路%1號").arg(phone.right(2).toInt() + 1));
+    row.insert("purposes", QJsonArray{Records::kPurposes.at(index == 0 ? 0 : 1)});
+    row.insert("items", QJsonArray{water ? Records::kWaterItem : Records::kGasItem});
+    row.insert("other_item_text", "");
+    row.insert("water_replace_cycle", water ? QStringLiteral("一年") : QString());
+    row.insert("next_replace_date_roc", water ? nextYear : QString());
+    row.insert("warranty_end_date_roc", water ? QString() : nextYear);
+    row.insert("notes", water ? QStringLiteral("更換RO膜") : QStringLiteral("定期保養"));
+    row.insert("created_at", createdAt.toString("yyyy-MM-dd HH:mm:ss"));
+    return row;
+}
+
+void StandInServer::buildDataset() {
+    // Three rows share each timestamp, as rows entered in the same second do.
+    const QDateTime start(QDate(2015, 1, 1), QTime(9, 0));
+    const int customers = qMax(1, config.datasetRows / 5);
+    dataset.reserve(config.datasetRows);
+    for (int i = 0; i < config.datasetRows; ++i) {
+        const QString phone = QString("09%1").arg(i % customers, 8, 10, QChar('0'));
+        dataset.append(syntheticRow(phone, i / customers, start.addSecs(qint64(i / 3) * kDatasetStepSecs)));
+    }
+}
+
+void StandInServer::acceptConnections() {
+    while (QTcpSocket *socket = tcp->nextPendingConnection()) {
+        connections.insert(socket, Connection());
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() {
+            readRequests(socket);
+        });
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            connections.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void StandInServer::readRequests(QTcpSocket *socket) {
+    auto it = connections.find(socket);
+    if (it == connections.end()) {
+        return;
+    }
+    it->buffer += socket->readAll();
+
+    // Replies go out in request order, so a pipelined request waits until the previous delayed reply is written.
+    while (!it->busy) {
+        const qsizetype headerEnd = it->buffer.indexOf("\r\n\r\n");
+        if (headerEnd < 0) {
+            if (it->buffer.size() > kMaxHeaderBytes) {
+                socket->abort();
+            }
+            return;
+        }
+
+        const QList<QByteArray> lines = it->buffer.left(headerEnd).split('\n');
+        const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+        if (requestLine.size() != 3) {
+            socket->abort();
+            return;
+        }
+        QHash<QByteArray, QByteArray> headers;
+        for (int i = 1; i < lines.size(); ++i) {
+            const qsizetype colon = lines.at(i).indexOf(':');
+            if (colon > 0) {
+                headers.insert(lines.at(i).left(colon).trimmed().toLower(), lines.at(i).mid(colon + 1).trimmed());
+            }
+        }
+
+        const qint64 contentLength = headers.value("content-length", "0").toLongLong();
+        if (it->buffer.size() < headerEnd + 4 + contentLength) {
+            return;
+        }
+        const QByteArray body = it->buffer.mid(headerEnd + 4, contentLength);
+        it->buffer.remove(0, headerEnd + 4 + contentLength);
+
+        const QByteArray connectionHeader = headers.value("connection").toLower();
+        bool keepAlive = requestLine.at(2) == "HTTP/1.1" ? connectionHeader != "close" : connectionHeader == "keep-alive";
+        Response response;
+        if (headers.contains("transfer-encoding")) {
+            response = textResponse(411, "Content-Length is required");
+            keepAlive = false;
+        } else if (headers.value("content-encoding").toLower() == "gzip") {
+            // Apps Script does not inflate request bodies either.
+            response = textResponse(415, "gzip request bodies are not supported");
+        } else {
+            response = handle(requestLine.at(0), QUrlQuery(QUrl::fromEncoded(requestLine.at(1))), body);
+        }
+        const bool gzip = config.gzipResponses && response.body.size() >= kMinGzipBytes
+                          && headers.value("accept-encoding").toLower().contains("gzip");
+
+        it->busy = true;
+        QTimer::singleShot(nextDelayMs(), socket, [this, socket, response, keepAlive, gzip]() {
+            writeResponse(socket, response, keepAlive, gzip);
+            if (!keepAlive) {
+                socket->disconnectFromHost();
+                return;
+            }
+            auto current = connections.find(socket);
+            if (current != connections.end()) {
+                current->busy = false;
+                readRequests(socket);
+            }
+        });
+    }
+}
+
+void StandInServer::writeResponse(QTcpSocket *socket, const Response &response, bool keepAlive, bool gzip) {
+    const QByteArray body = gzip ? Compression::gzip(response.body) : response.body;
+    QByteArray head = "HTTP/1.1 " + QByteArray::number(response.status) + ' ' + reasonPhrase(response.status) + "\r\n";
+    head += "Content-Type: " + response.contentType + "\r\n";
+    if (gzip) {
+        head += "Content-Encoding: gzip\r\n";
+    }
+    head += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    head += keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+    socket->write(head);
+    socket->write(body);
+}
+
+int StandInServer::nextDelayMs() {
+    return config.latencyMs + (config.jitterMs > 0 ? int(rng.bounded(config.jitterMs + 1)) : 0);
+}
+
+StandInServer::Response StandInServer::handle(const QByteArray &method, const QUrlQuery &query, const QByteArray &body) {
+    ++counters.requests;
+    if (config.errorRate > 0 && rng.generateDouble() < config.errorRate) {
+        ++counters.injectedErrors;
+        return textResponse(500, "Injected server error");
+    }
+    if (config.nonJsonRate > 0 && rng.generateDouble() < config.nonJsonRate) {
+        ++counters.injectedNonJson;
+        Response response;
+        response.contentType = "text/html; charset=utf-8";
+        response.body = kLoginPage;
+        return response;
+    }
+
+    if (method == "GET") {
+        return handleGet(query);
+    }
+    if (method == "POST") {
+        if (body.size() > config.maxBodyBytes) {
+            return textResponse(413, "Request body too large");
+        }
+        return handlePost(body);
+    }
+    return textResponse(405, "Only GET and POST are supported");
+}
+
+StandInServer::Response StandInServer::handleGet(const QUrlQuery &query) {
+    if (query.queryItemValue("sync") == "1") {
+        ++counters.syncPages;
+        const int limit = qBound(1, query.queryItemValue("limit").toInt(), 5000);
+        const qint64 first = qBound<qint64>(0, query.queryItemValue("after").toLongLong(), dataset.size());
+        const qint64 end = qMin<qint64>(dataset.size(), first + limit);
+
+        QJsonArray rows;
+        for (qint64 i = first; i < end; ++i) {
+            rows.append(dataset.at(i));
+        }
+        return jsonResponse(QJsonObject{{"ok", true}, {"rows", rows}, {"next", QString::number(end)}, {"has_more", end < dataset.size()}});
+    }
+
+    const QString phone = query.queryItemValue("phone");
+    if (phone.isEmpty()) {
+        return envelopeError("missing phone");
+    }
+    ++counters.lookups;
+    QJsonArray rows = customerRows(phone);
+    if (query.queryItemValue("only_water") == "1") {
+        QJsonArray water;
+        for (const auto &row : std::as_const(rows)) {
+            if (row.toObject().value("items").toArray().contains(Records::kWaterItem)) {
+                water.append(row);
+            }
+        }
+        rows = water;
+    }
+    return jsonResponse(QJsonObject{{"ok", true}, {"rows", rows}});
+}
+
+StandInServer::Response StandInServer::handlePost(const QByteArray &body) {
+    const QJsonDocument doc = QJsonDocument::fromJson(body);
+    if (!doc.isObject()) {
+        return envelopeError("invalid JSON");
+    }
+    const QJsonObject payload = doc.object();
+    const QString type = payload.value("type").toString();
+    ++counters.posts;
+
+    if (type == "customer_service") {
+        QString error;
+        return storeRecord(payload.value("data").toObject(), &error) ? jsonResponse(QJsonObject{{"ok", true}}) : envelopeError(error);
+    }
+    if (type == "customer_service_batch") {
+        QJsonArray results;
+        for (const auto &record : payload.value("records").toArray()) {
+            QString error;
+            results.append(storeRecord(record.toObject(), &error) ? QJsonObject{{"ok", true}}
+                                                                  : QJsonObject{{"ok", false}, {"error", error}});
+        }
+        return jsonResponse(QJsonObject{{"ok", true}, {"results", results}});
+    }
+    return envelopeError(QString("unknown type: %1").arg(type));
+}
+
+bool StandInServer::storeRecord(const QJsonObject &data, QString *error) {
+    const QString phone = data.value("phone").toString();
+    const QString createdAt = data.value("created_at").toString();
+    if (phone.isEmpty() || createdAt.isEmpty()) {
+        *error = "phone and created_at are required";
+        return false;
+    }
+    posted[phone].append(data);
+    // Appended whatever its created_at, so clients that already synced past that time still receive it.
+    dataset.append(data);
+    ++counters.recordsStored;
+    return true;
+}
+
+QJsonArray StandInServer::customerRows(const QString &phone) {
+    QRandomGenerator generator(config.seed ^ quint32(qHash(phone, 0)));
+    const qint64 stepSecs = qMax<qint64>(600, kCustomerSpanSecs / qMax(1, config.rowsPerCustomer));
+    QDateTime createdAt(QDate(2015, 1, 1).addDays(generator.bounded(1000)), QTime(9, 0));
+
+    QJsonArray rows;
+    for (int i = 0; i < config.rowsPerCustomer; ++i) {
+        createdAt = createdAt.addSecs(stepSecs / 2 + qint64(generator.bounded(quint64(stepSecs))));
+        rows.append(syntheticRow(phone, i, createdAt));
+    }
+    for (const auto &row : posted.value(phone)) {
+        rows.append(row);
+    }
+    return rows;
+}
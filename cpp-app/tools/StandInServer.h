@@ -0,0 +1,93 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QObject>
+#include <QRandomGenerator>
+#include <QString>
+#include <QStringList>
+#include <QUrlQuery>
+#include <QVector>
+
+class QCommandLineParser;
+class QDateTime;
+class QTcpServer;
+class QTcpSocket;
+
+// Local stand-in for the Apps Script endpoint: the same GET/POST contract over plain HTTP/1.1, synthetic
+// customers, and injectable latency, HTTP errors and non-JSON replies.
+class StandInServer : public QObject {
+    Q_OBJECT
+
+public:
+    struct Config {
+        QString host = QStringLiteral("127.0.0.1");
+        quint16 port = 8765;
+        int rowsPerCustomer = 20;
+        int datasetRows = 10000;
+        int latencyMs = 0;
+        int jitterMs = 0;
+        double errorRate = 0;
+        double nonJsonRate = 0;
+        qint64 maxBodyBytes = 4 * 1024 * 1024;
+        bool gzipResponses = true;
+        quint32 seed = 1;
+    };
+
+    struct Response {
+        int status = 200;
+        QByteArray contentType = "application/json; charset=utf-8";
+        QByteArray body;
+    };
+
+    struct Stats {
+        qint64 requests = 0;
+        qint64 lookups = 0;
+        qint64 syncPages = 0;
+        qint64 posts = 0;
+        qint64 recordsStored = 0;
+        qint64 injectedErrors = 0;
+        qint64 injectedNonJson = 0;
+    };
+
+    explicit StandInServer(const Config &config, QObject *parent = nullptr);
+
+    bool listen();
+    quint16 port() const;
+    QString url() const;
+    QString errorString() const;
+    Stats stats() const;
+
+    Response handle(const QByteArray &method, const QUrlQuery &query, const QByteArray &body);
+
+    static void addOptions(QCommandLineParser &parser);
+    static Config configFromOptions(const QCommandLineParser &parser);
+    static QJsonObject syntheticRow(const QString &phone, int index, const QDateTime &createdAt);
+
+private:
+    struct Connection {
+        QByteArray buffer;
+        bool busy = false;
+    };
+
+    void acceptConnections();
+    void readRequests(QTcpSocket *socket);
+    void writeResponse(QTcpSocket *socket, const Response &response, bool keepAlive, bool gzip);
+    int nextDelayMs();
+    Response handleGet(const QUrlQuery &query);
+    Response handlePost(const QByteArray &body);
+    bool storeRecord(const QJsonObject &data, QString *error);
+    QJsonArray customerRows(const QString &phone);
+    void buildDataset();
+
+    Config config;
+    QTcpServer *tcp = nullptr;
+    QHash<QTcpSocket *, Connection> connections;
+    QRandomGenerator rng;
+    QHash<QString, QJsonArray> posted;
+    // In the order rows were stored; the index is the sequence number the sync cursor pages on.
+    QVector<QJsonObject> dataset;
+    Stats counters;
+};